@@ -0,0 +1,394 @@
+/*
+ *  File name: hash.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Benchmark of the table of parked cars: the Robin Hood
+ *      h_table (and the typed car map made as it), against the table of
+ *      chained lists it replaced, on tags that collide.
+ *
+ *  Implementation details:
+ *    The chained table is kept here as it was: 3001 lists of LinkedList,
+ *    with the old hash of three characters of the tag. It is also run with
+ *    the new hash (car_function), to tell the gain of the hash from the gain
+ *    of the table.
+ *
+ *    Each table puts all the tags, gets them all (and as many missing ones),
+ *    and removes them all, in the order the cars would leave. The tags are
+ *    sequential plates (Va1, Va2, ...), which all but three characters
+ *    share, and random plates.
+ *
+ *    Usage: bench_hash [number of tags], 50000 by default.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "h_table.h"
+#include "LinkedList.h"
+#include "containers.h"
+#include "garage.h"
+
+#define CHAIN_SIZE 3001
+#define TAG_SIZE 16
+#define N_TABLES 4
+
+#define tag_equal(a, b) (strcmp((a), (b)) == 0)
+
+DEFINE_HASHMAP(tag_map, char*, char*, car_function, tag_equal)
+
+/*
+ *  Data Type: chain
+ *  Description: Structure with:
+ *      1) Number of lists, and the lists (of chain_item).
+ *      2) Hash function, giving the list of a key.
+ */
+typedef struct _chain {
+  int size;
+  LinkedList **buckets;
+  unsigned long (*hash_function)(Item);
+} chain;
+
+/*
+ *  Data Type: chain_item
+ *  Description: Structure with the item stored and its key.
+ */
+typedef struct _chain_item {
+  Item this;
+  Item key;
+} chain_item;
+
+/*
+ *  Data Type: bench_table
+ *  Description: Structure with the name of a table, and its functions (as
+ *      put, get and remove of h_table).
+ */
+typedef struct _bench_table {
+  char *name;
+  void* (*create)( unsigned long (*)(Item) );
+  void (*put)( void* , Item , Item );
+  Item (*get)( void* , Item );
+  Item (*remove)( void* , Item );
+  void (*destroy)( void* );
+  unsigned long (*hash)(Item);
+} bench_table;
+
+unsigned long old_function( Item c1 );
+int compare_tag( Item c1 , Item c2 );
+void* new_chain( unsigned long (*hash)(Item) );
+void put_chain( void *t , Item this , Item key );
+Item get_chain( void *t , Item key );
+Item remove_chain( void *t , Item key );
+void destroy_chain( void *t );
+void* new_robin( unsigned long (*hash)(Item) );
+void put_robin( void *t , Item this , Item key );
+Item get_robin( void *t , Item key );
+Item remove_robin( void *t , Item key );
+void destroy_robin( void *t );
+void* new_map( unsigned long (*hash)(Item) );
+void put_map( void *t , Item this , Item key );
+Item get_map( void *t , Item key );
+Item remove_map( void *t , Item key );
+void destroy_map( void *t );
+char* make_tags( int n , int sequential );
+void run_table( bench_table *b , char *tags , char *missing , int n );
+double seconds( clock_t start );
+
+int main( int argc , char **argv )
+{
+  bench_table tables[N_TABLES];
+  char *tags, *missing;
+  int n = 50000, i, sequential;
+
+  if ( argc > 1 && (n = atoi(argv[1])) <= 0 ) {
+    fprintf(stderr, "Usage: %s [number of tags]\n", argv[0]);
+    exit(1);
+  }
+
+  tables[0].name = "chained, old hash";
+  tables[0].create = new_chain;
+  tables[0].put = put_chain;
+  tables[0].get = get_chain;
+  tables[0].remove = remove_chain;
+  tables[0].destroy = destroy_chain;
+  tables[0].hash = old_function;
+
+  tables[1] = tables[0];
+  tables[1].name = "chained, car_function";
+  tables[1].hash = car_function;
+
+  tables[2].name = "robin hood, car_function";
+  tables[2].create = new_robin;
+  tables[2].put = put_robin;
+  tables[2].get = get_robin;
+  tables[2].remove = remove_robin;
+  tables[2].destroy = destroy_robin;
+  tables[2].hash = car_function;
+
+  tables[3].name = "robin hood map, typed";
+  tables[3].create = new_map;
+  tables[3].put = put_map;
+  tables[3].get = get_map;
+  tables[3].remove = remove_map;
+  tables[3].destroy = destroy_map;
+  tables[3].hash = car_function;
+
+  srand( 1 );
+  for ( sequential = 1 ; sequential >= 0 ; sequential-- ) {
+    tags = make_tags( n , sequential );
+    missing = make_tags( n , sequential );
+    /* The missing tags are the others with a letter changed. */
+    for ( i = 0 ; i < n ; i++ ) {
+      missing[i * TAG_SIZE] = 'W';
+    }
+
+    printf("%d %s tags: put / get / remove (seconds)\n", n, sequential ? "sequential" : "random");
+    for ( i = 0 ; i < N_TABLES ; i++ ) {
+      run_table( &tables[i] , tags , missing , n );
+    }
+
+    free( tags );
+    free( missing );
+  }
+
+  return 0;
+}
+
+/* Makes n tags, Va1, Va2, ... if sequential, or random plates (as AB-12-CD). */
+char* make_tags( int n , int sequential )
+{
+  char *tags;
+  int i;
+
+  tags = (char*) malloc( n * TAG_SIZE );
+  mem_check(tags);
+
+  for ( i = 0 ; i < n ; i++ ) {
+    if ( sequential )
+      sprintf(tags + i * TAG_SIZE, "Va%d", i + 1);
+    else
+      sprintf(tags + i * TAG_SIZE, "V%c%c-%02d-%c%c", 'A' + rand() % 26, 'A' + rand() % 26,
+	      rand() % 100, 'A' + rand() % 26, 'A' + rand() % 26);
+  }
+
+  return tags;
+}
+
+/* Puts, gets and removes the tags in a table, writing the time of each. */
+void run_table( bench_table *b , char *tags , char *missing , int n )
+{
+  void *t;
+  clock_t start;
+  double put, get, rem;
+  int i, found = 0;
+
+  t = b->create( b->hash );
+
+  start = clock();
+  for ( i = 0 ; i < n ; i++ ) {
+    b->put( t , tags + i * TAG_SIZE , tags + i * TAG_SIZE );
+  }
+  put = seconds( start );
+
+  start = clock();
+  for ( i = 0 ; i < n ; i++ ) {
+    found += ( b->get( t , tags + i * TAG_SIZE ) != NULL );
+    found += ( b->get( t , missing + i * TAG_SIZE ) != NULL );
+  }
+  get = seconds( start );
+
+  start = clock();
+  for ( i = 0 ; i < n ; i++ ) {
+    found -= ( b->remove( t , tags + i * TAG_SIZE ) != NULL );
+  }
+  rem = seconds( start );
+
+  b->destroy( t );
+
+  /* The random tags may repeat, but each put is found and removed once. */
+  if ( found != 0 )
+    fprintf(stderr, "%s: %d tags lost\n", b->name, found);
+  printf("  %-26s %8.3f %8.3f %8.3f\n", b->name, put, get, rem);
+}
+
+/* Seconds of processor time since start. */
+double seconds( clock_t start )
+{
+  return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* The hash the chained table used: three characters of the tag (after the first). Its
+   precedence error is kept, the powers of 32 are (c*32)^2, (c*32)^1 and c^0. */
+unsigned long old_function( Item c1 )
+{
+  char *c = (char*) c1;
+  int result;
+
+  if ( strlen(c) >= 4 )
+    result = (c[1]*(32)^2) + (c[2]*(32)^1) + (c[3]*(32)^0);
+  else if ( strlen(c) == 3 )
+    result = (c[1]*(32)^2) + (c[2]*(32)^1) + (' '*(32)^0);
+  else
+    result = (c[1]*(32)^2) + (' '*(32)^1) + (' '*(32)^0);
+
+  return (unsigned long) result;
+}
+
+/* Returns 1 if the tags are equal (as the garage compares them). */
+int compare_tag( Item c1 , Item c2 )
+{
+  return tag_equal((char*) c1, (char*) c2);
+}
+
+/* Chained table: one list per bucket, new items at the head. */
+void* new_chain( unsigned long (*hash)(Item) )
+{
+  chain *new;
+  int i;
+
+  new = (chain*) malloc( sizeof(chain) );
+  mem_check(new);
+
+  new->size = CHAIN_SIZE;
+  new->buckets = (LinkedList**) malloc( CHAIN_SIZE * sizeof(LinkedList*) );
+  mem_check(new->buckets);
+  for ( i = 0 ; i < CHAIN_SIZE ; i++ ) {
+    new->buckets[i] = initLinkedList();
+  }
+  new->hash_function = hash;
+
+  return new;
+}
+
+void put_chain( void *t , Item this , Item key )
+{
+  chain *c = (chain*) t;
+  chain_item *ci;
+  int pos = c->hash_function(key) % c->size;
+
+  ci = (chain_item*) malloc( sizeof(chain_item) );
+  mem_check(ci);
+  ci->this = this;
+  ci->key = key;
+
+  c->buckets[pos] = insertUnsortedLinkedList( c->buckets[pos] , (Item) ci );
+}
+
+Item get_chain( void *t , Item key )
+{
+  chain *c = (chain*) t;
+  LinkedList *l;
+  chain_item *ci;
+
+  for ( l = c->buckets[c->hash_function(key) % c->size] ; l != NULL ; l = getNextNodeLinkedList(l) ) {
+    ci = (chain_item*) getItemLinkedList(l);
+    if ( compare_tag(key, ci->key) )
+      return ci->this;
+  }
+
+  return NULL;
+}
+
+Item remove_chain( void *t , Item key )
+{
+  chain *c = (chain*) t;
+  LinkedList *l, *prev;
+  chain_item *ci;
+  Item this;
+  int pos = c->hash_function(key) % c->size;
+
+  for ( l = c->buckets[pos], prev = NULL ; l != NULL ; prev = l, l = getNextNodeLinkedList(l) ) {
+    ci = (chain_item*) getItemLinkedList(l);
+    if ( compare_tag(key, ci->key) ) {
+      this = ci->this;
+      free(ci);
+      if ( prev == NULL )
+	c->buckets[pos] = removeHeadLinkedList(c->buckets[pos]);
+      else
+	removeMiddleLinkedList(prev);
+      return this;
+    }
+  }
+
+  return NULL;
+}
+
+void destroy_chain( void *t )
+{
+  chain *c = (chain*) t;
+  int i;
+
+  for ( i = 0 ; i < c->size ; i++ ) {
+    while ( c->buckets[i] != NULL ) {
+      free( getItemLinkedList(c->buckets[i]) );
+      c->buckets[i] = removeHeadLinkedList(c->buckets[i]);
+    }
+  }
+  free(c->buckets);
+  free(c);
+}
+
+/* Robin Hood table: h_table, started as small as the garage starts it. */
+void* new_robin( unsigned long (*hash)(Item) )
+{
+  return new_h_table( 16 , hash , compare_tag , NULL );
+}
+
+void put_robin( void *t , Item this , Item key )
+{
+  put_h_table( (h_table*) t , this , key );
+}
+
+Item get_robin( void *t , Item key )
+{
+  return get_h_table( (h_table*) t , key );
+}
+
+Item remove_robin( void *t , Item key )
+{
+  return remove_h_table( (h_table*) t , key );
+}
+
+void destroy_robin( void *t )
+{
+  destroy_h_table( (h_table*) t );
+}
+
+/* Typed Robin Hood map, as the garage keeps its parked cars (the hash is fixed). */
+void* new_map( unsigned long (*hash)(Item) )
+{
+  tag_map *m;
+
+  m = (tag_map*) malloc( sizeof(tag_map) );
+  mem_check(m);
+  tag_map_init( m , 16 );
+
+  return m;
+}
+
+void put_map( void *t , Item this , Item key )
+{
+  tag_map_put( (tag_map*) t , (char*) key , (char*) this );
+}
+
+Item get_map( void *t , Item key )
+{
+  char **v = tag_map_get( (tag_map*) t , (char*) key );
+
+  return v == NULL ? NULL : *v;
+}
+
+Item remove_map( void *t , Item key )
+{
+  char *v;
+
+  return tag_map_remove( (tag_map*) t , (char*) key , &v ) ? v : NULL;
+}
+
+void destroy_map( void *t )
+{
+  tag_map_free( (tag_map*) t );
+  free(t);
+}
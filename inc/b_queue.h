@@ -0,0 +1,32 @@
+/*
+ *  File name: b_queue.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: C-Implementation of a bucket priority queue of integers
+ *      (Dial's algorithm). Has functions to insert an integer with an integer
+ *      key and extract the one with the lowest key.
+ *
+ *  Implementation details:
+ *    The queue has a circular array of buckets, one per key, and each bucket
+ *    is a FIFO array of integers. With n buckets, the keys inserted must be
+ *    between the last key removed and that key plus n-1, which is the case
+ *    of searches in graphs whose weights are smaller than n.
+ *
+ */
+
+#ifndef B_QUEUE_H
+#define B_QUEUE_H
+
+#include "defs.h"
+
+typedef struct _b_queue b_queue;
+
+b_queue* new_b_queue( int n_buckets );
+void destroy_b_queue( b_queue *q );
+void clear_b_queue( b_queue *q );
+void insert_b_queue( b_queue *q , int this , int key );
+int remove_b_queue( b_queue *q , int *key );
+int isEmpty_b_queue( b_queue *q );
+
+#endif
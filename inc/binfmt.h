@@ -0,0 +1,58 @@
+/*
+ *  File name: binfmt.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Binary formats of the cars file (events) and of the output
+ *      file (results), with the varints and the table of tags they share.
+ *
+ *  Implementation details:
+ *    A file starts with its magic (EVENTS_MAGIC or RESULTS_MAGIC). The
+ *    integers are varints (7 bits per byte, lowest first, the high bit set
+ *    on all but the last), signed ones in zigzag. Each tag is written whole
+ *    only the first time, ended by a '\0': a record starts with the number
+ *    of its tag, in the order they first came, and the number that is next
+ *    (the size of the table) means a new tag follows.
+ *
+ *    Event:  tag, t (from the last event), type (0 if none), number of
+ *            coordinates given (0 to 3), and the coordinates.
+ *    Result: the N and M of the garage, after the magic. Then each move is
+ *            tag, t (from the last move), and the cell of the move (see
+ *            get_index) times 8 plus its code in MOVE_CODES. The summary 'x'
+ *            has no cell, and is followed by the time to the park, the time
+ *            to the arrival, and the cost less the one they make.
+ *
+ */
+
+#ifndef BINFMT_H
+#define BINFMT_H
+
+#include "defs.h"
+
+#define MAGIC_SIZE 8
+#define EVENTS_MAGIC "apkEVT1\n"
+#define RESULTS_MAGIC "apkPTS1\n"
+
+/* Moves, by code. */
+#define MOVE_CODES "imepasx"
+#define MOVE_BITS 3
+
+/* Longest varint of 32 bits. */
+#define MAX_VARINT 5
+
+#define zigzag(x) ((x) < 0 ? 2 * (unsigned long) -((long) (x)) - 1 : 2 * (unsigned long) (x))
+#define unzigzag(u) ((u) & 1 ? -(long) ((u) >> 1) - 1 : (long) ((u) >> 1))
+
+typedef struct _tag_table tag_table;
+
+char* put_varint( char *p , unsigned long x );
+int get_varint( char **p , char *end , unsigned long *x );
+int move_code( char m );
+
+tag_table* new_tags( int own );
+int find_tag( tag_table *t , char *tag );
+int add_tag( tag_table *t , char *tag );
+char* get_tag( tag_table *t , char **p , char *end );
+void free_tags( tag_table *t );
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ *  File name: containers.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Containers made for a given type: a vector and a hash
+ *      table. Each DEFINE macro makes the type NAME and its functions
+ *      NAME_init, NAME_push, ... for the element types given.
+ *
+ *  Implementation details:
+ *    The elements are kept in the containers themselves (not as Items), and
+ *    compared and hashed by the macros or functions given, which the
+ *    compiler can inline. The functions are static, so each file makes the
+ *    containers it uses. The generic containers (LinkedList, queue, h_table)
+ *    are still there for the code that needs an Item. There is no heap: the
+ *    heaps of the searches and of the parks are indexed (see i_heap.h).
+ *
+ *    DEFINE_VEC(NAME, T): array of T that doubles when full.
+ *    DEFINE_HASHMAP(NAME, K, V, HASH, EQ): hash table of V by key K, by
+ *        open addressing in Robin Hood order (as h_table), that doubles when
+ *        7/8 full. HASH(k) gives an unsigned long, EQ(a, b) is true if the
+ *        keys are equal.
+ *
+ */
+
+#ifndef CONTAINERS_H
+#define CONTAINERS_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "defs.h"
+
+#ifdef __GNUC__
+#define CONTAINER_FN static __inline__
+#else
+#define CONTAINER_FN static
+#endif
+
+/* Vector: data[0] to data[n-1], room for size. */
+#define DEFINE_VEC(NAME, T)						\
+  typedef struct {							\
+    T *data;								\
+    int n, size;							\
+  } NAME;								\
+									\
+  CONTAINER_FN void NAME##_init( NAME *v )				\
+  {									\
+    v->data = NULL;							\
+    v->n = v->size = 0;							\
+  }									\
+									\
+  CONTAINER_FN void NAME##_free( NAME *v )				\
+  {									\
+    free( v->data );							\
+    NAME##_init( v );							\
+  }									\
+									\
+  CONTAINER_FN void NAME##_push( NAME *v , T x )			\
+  {									\
+    if ( v->n == v->size ) {						\
+      v->size = 2 * v->size + 8;					\
+      v->data = (T*) realloc( v->data , v->size * sizeof(T) );		\
+      mem_check(v->data);						\
+    }									\
+    v->data[v->n++] = x;						\
+  }
+
+/* Hash table: slots a power of two in size, dist is -1 in empty slots. */
+#define DEFINE_HASHMAP(NAME, K, V, HASH, EQ)				\
+  typedef struct {							\
+    K key;								\
+    V value;								\
+    unsigned long hash;							\
+    int dist;								\
+  } NAME##_slot;							\
+									\
+  typedef struct {							\
+    NAME##_slot *slots;							\
+    int size, n;							\
+  } NAME;								\
+									\
+  CONTAINER_FN void NAME##_init( NAME *m , int size )			\
+  {									\
+    int i;								\
+									\
+    for ( m->size = 8 ; m->size < size ; m->size *= 2 );		\
+    m->n = 0;								\
+    m->slots = (NAME##_slot*) malloc( m->size * sizeof(NAME##_slot) );	\
+    mem_check(m->slots);						\
+    for ( i = 0 ; i < m->size ; i++ )					\
+      m->slots[i].dist = -1;						\
+  }									\
+									\
+  CONTAINER_FN void NAME##_free( NAME *m )				\
+  {									\
+    free( m->slots );							\
+    m->slots = NULL;							\
+    m->size = m->n = 0;							\
+  }									\
+									\
+  /* Places a slot, moving forward the ones closer to their own. */	\
+  CONTAINER_FN void NAME##_place( NAME *m , NAME##_slot s )		\
+  {									\
+    NAME##_slot aux;							\
+    int pos, mask = m->size - 1;					\
+									\
+    pos = (int) ((s.hash + s.dist) & mask);				\
+    while ( m->slots[pos].dist != -1 ) {				\
+      if ( m->slots[pos].dist < s.dist ) {				\
+	aux = m->slots[pos];						\
+	m->slots[pos] = s;						\
+	s = aux;							\
+      }									\
+      pos = (pos + 1) & mask;						\
+      s.dist++;								\
+    }									\
+    m->slots[pos] = s;							\
+  }									\
+									\
+  /* Returns the slot of the key, or -1. */				\
+  CONTAINER_FN int NAME##_find( NAME *m , K key )			\
+  {									\
+    unsigned long hash = HASH(key);					\
+    int pos, dist, mask = m->size - 1;					\
+									\
+    pos = (int) (hash & mask);						\
+    for ( dist = 0 ; m->slots[pos].dist >= dist ; dist++ ) {		\
+      if ( m->slots[pos].hash == hash && EQ(key, m->slots[pos].key) )	\
+	return pos;							\
+      pos = (pos + 1) & mask;						\
+    }									\
+									\
+    return -1;								\
+  }									\
+									\
+  CONTAINER_FN void NAME##_put( NAME *m , K key , V value )		\
+  {									\
+    NAME##_slot *old = m->slots, s;					\
+    int i, old_size = m->size;						\
+									\
+    if ( 8 * (m->n + 1) > 7 * m->size ) {				\
+      NAME##_init( m , 2 * old_size );					\
+      m->n = 0;								\
+      for ( i = 0 ; i < old_size ; i++ ) {				\
+	if ( old[i].dist != -1 ) {					\
+	  old[i].dist = 0;						\
+	  NAME##_place( m , old[i] );					\
+	  m->n++;							\
+	}								\
+      }									\
+      free( old );							\
+    }									\
+									\
+    s.key = key;							\
+    s.value = value;							\
+    s.hash = HASH(key);							\
+    s.dist = 0;								\
+    NAME##_place( m , s );						\
+    m->n++;								\
+  }									\
+									\
+  /* Returns a pointer to the value of the key (NULL if not there). */	\
+  CONTAINER_FN V* NAME##_get( NAME *m , K key )				\
+  {									\
+    int pos = NAME##_find( m , key );					\
+									\
+    return pos == -1 ? NULL : &(m->slots[pos].value);			\
+  }									\
+									\
+  /* Removes the key, writing its value to value. Returns 0 if it was	\
+     not there. */							\
+  CONTAINER_FN int NAME##_remove( NAME *m , K key , V *value )		\
+  {									\
+    int pos, next, mask = m->size - 1;					\
+									\
+    if ( (pos = NAME##_find( m , key )) == -1 )				\
+      return 0;								\
+    *value = m->slots[pos].value;					\
+									\
+    /* Shifts back the following slots, until one empty or in its own. */ \
+    for ( next = (pos + 1) & mask ; m->slots[next].dist > 0 ; next = (next + 1) & mask ) { \
+      m->slots[pos] = m->slots[next];					\
+      m->slots[pos].dist--;						\
+      pos = next;							\
+    }									\
+    m->slots[pos].dist = -1;						\
+    m->n--;								\
+									\
+    return 1;								\
+  }
+
+#endif
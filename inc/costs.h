@@ -0,0 +1,27 @@
+/*
+ *  File name: costs.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Park costs over dense arrays, indexed by park: the weight
+ *      from an entry, the weight to the nearest exit and a mask of the parks
+ *      that can be used.
+ *
+ *  Implementation details:
+ *    The cost of park i is wt_e[i] + COST_MULT * wt_a[i], when ok[i] is -1
+ *    (all bits set), and the park is ignored when ok[i] is 0 or one of its
+ *    weights is -1 (not reached). The loops are
+ *    vectorized with AVX2 or SSE4.1 when the processor has them (checked at
+ *    run time), and use plain C otherwise. All versions give the same result.
+ *
+ */
+
+#ifndef COSTS_H
+#define COSTS_H
+
+#include "defs.h"
+
+void costs_park( int n , int *wt_e , int *wt_a , int *ok , int *cost );
+int argmin_park( int n , int *wt_e , int *wt_a , int *ok );
+
+#endif
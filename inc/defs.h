@@ -29,10 +29,14 @@
 #ifndef defsHeader
 #define defsHeader
 
-#define LINE_SIZE 200
+#include <stddef.h>
+
 #define COST_MULT 3
 #define H_TABLE_SIZE 3001
 
+/* First value of an FNV-1a hash (the seed of fnv1a). */
+#define FNV_OFFSET 2166136261UL
+
 #define EMPTY 0
 #define UP 1
 #define DOWN 2
@@ -48,19 +52,34 @@
 #define get_y(I, M, N) (((I)-(get_z(I, N, M)*(N)*(M))) / (N))
 
 
+/* Cell kinds -> depend only on the map symbol, and define to which neighbours
+   a cell is connected.
+ */
+#define CELL_WALL 0   /* '@': not connected. */
+#define CELL_FREE 1   /* Connected to every cell that is not a wall. */
+#define CELL_STOP 2   /* Parks and accesses: not connected to each other. */
+#define CELL_RAMP 3   /* 'u': free, and also connected to the cell above. */
+
+#define linked_kinds(a, b) ((a) != CELL_WALL && (b) != CELL_WALL && ((a) != CELL_STOP || (b) != CELL_STOP))
+
 /* Bit flag -> used to mark in the id which positions have restrictions.
    0 -> no restrictions  ;  1 -> has restrictions
  */
 #define ID_FLAG 0x80000000
 
 /* Mask used to recover each identificaton. */
-#define ID_MASK 0x7FFFFFFF
+#define ID_MASK 0x000000FF
+
+/* The cell kind is kept after the identification. */
+#define KIND_SHIFT 8
 
 #define get_flag(x) ((x) & ID_FLAG)
 #define get_id(x) ((x) & ID_MASK)
+#define get_kind(x) (((x) >> KIND_SHIFT) & 3)
 #define set_flag(x) ((x) = ((x) | ID_FLAG))
-#define reset_flag(x) ((x) = ((x) & ID_MASK))
-#define change_id(x, y) ((x) = (get_flag(x) | (y)))
+#define reset_flag(x) ((x) = ((x) & ~ID_FLAG))
+#define change_id(x, y) ((x) = (((x) & ~ID_MASK) | (y)))
+#define new_id(id, kind) ((id) | ((kind) << KIND_SHIFT))
 
 /*
  *  Data type: Item
@@ -72,6 +91,7 @@ typedef void * Item;
 int *new_int( int i );
 int cmp_int( Item a , Item b );
 void print_int( Item a , FILE *fp );
+unsigned long fnv1a( const void *data , size_t size , unsigned long seed );
 
 /* End of: Protect multiple inclusions                              */
 #endif
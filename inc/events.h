@@ -0,0 +1,48 @@
+/*
+ *  File name: events.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Reading of the cars file, a car event at a time, in text
+ *      ("tag t type x y z", a line each) or in the binary format of binfmt.h.
+ *
+ *  Implementation details:
+ *    The format is told by the start of the file (EVENTS_MAGIC). Only the
+ *    fields of the event that are in the file are written: the type and the
+ *    position of the last event stay when the next one has none. Events with
+ *    no tag or no instant are skipped.
+ *
+ */
+
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "defs.h"
+#include "scanner.h"
+
+/*
+ *  Data Type: car_event
+ *  Description: Structure with:
+ *      1) Tag and instant.
+ *      2) Type, and the position (x, y, z).
+ *      3) Number of fields read, with the tag (1 with no type, then 2 plus
+ *         the coordinates).
+ */
+typedef struct _car_event {
+  char *tag;
+  int t;
+  char type;
+  int pos[3];
+  int fields;
+} car_event;
+
+typedef struct _events events;
+
+events* open_events( char *path );
+events* stream_events( char *path );
+int binary_events( events *ev );
+int tags_last( events *ev );
+int next_event( events *ev , car_event *e );
+void close_events( events *ev );
+
+#endif
@@ -20,6 +20,8 @@
 #include "restriction.h"
 #include "h_table.h"
 #include "queue.h"
+#include "writer.h"
+#include "events.h"
 
 typedef struct _garage garage;
 typedef struct _access access;
@@ -27,21 +29,37 @@ typedef struct _park park;
 typedef struct _car car;
 typedef struct _p_car p_car;
 
-void read_line(char *row, int n, FILE *fp);
-void read_dimensions( FILE* fp , garage* g );
-void read_map (garage *g , FILE* fp, int floor );
-void read_accesses ( garage* g, FILE* fp, int* );
+/* Graph representation: stored edges (CSR), implicit grid, or chosen by size. */
+#define GRAPH_AUTO 0
+#define GRAPH_CSR 1
+#define GRAPH_GRID 2
+
+/* Tree format: full arrays, packed, or chosen by size. */
+#define TREE_AUTO 0
+#define TREE_FULL 1
+#define TREE_PACKED 2
+
+void read_line( scanner *in );
+void read_dimensions( scanner* in , garage* g );
+void read_map (garage *g , scanner* in, int floor );
+void read_accesses ( garage* g, scanner* in, int* );
+int get_identifier( char symbol );
 void fill_identifier( int*, char* row, int j, int i, int floor, int N, int M );
-garage* read_entryfile ( FILE* fp );
-void read_restrict( garage *g, FILE *fpr );
+garage* read_entryfile ( scanner* in , int graph_type , int tree_type );
+int save_garage( garage *g , char *path , model_key key );
+garage* map_garage( char *path , model_key key , int graph_type , int tree_type , long budget );
+void read_restrict( garage *g, scanner *in );
 void no_restrict( garage *g );
 void path_garage( garage *g , int(*random_int)(int, int));
-void write_direction(garage *g, FILE* fp, car *c, LinkedList* path, int p, int t );
-int escreve_saida(FILE *fp, char *vid, int tk, int pX, int pY, int pZ, char tm );
-int park_car(car* c,  garage * g, FILE* fp, int );
-void process_car_file( garage *g , FILE *car_in , FILE *car_out );
+void write_direction(garage *g, writer* out, car *c, int* path, int n, int p, int t );
+int park_car(car* c,  garage * g, writer* out, int );
+int process_car_file( garage *g , events *car_in , writer *out );
 void mark_invalid( garage *g );
-void remove_car( garage * g, char * tag, FILE * fp, int t );
+int remove_car( garage * g, char * tag, writer * out, int t );
+unsigned long car_function( Item c1 );
+void set_tree_budget( garage *g , long budget );
+void tree_stats( garage *g , long *hits , long *misses , long *evictions );
+void size_garage( garage *g , int *N , int *M , int *P );
 void destroy_garage( garage * g );
 
 #endif /* GARAGE_H_INCLUDED */
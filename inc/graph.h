@@ -7,10 +7,27 @@
  *               with specialized search functions embedded.
  *
  *  Implementation details:
- *    The graph structure is represented by a adjencency list. Each vertex,
- *    represent by an integer, corresponds to an index in a array of lists.
- *    The corresponding list stores the vertices to which it is connected,
- *    along with the edges weights.
+ *    The graph is built in two steps. While it is being read, the edges are
+ *    only collected in an array. Then finalize_graph packs them in compressed
+ *    sparse row (CSR) form: the edges of vertex v are the positions
+ *    offset[v] to offset[v+1]-1 of the to/weight arrays. The edges of each
+ *    vertex keep the order an adjacency list would give them (last inserted
+ *    first), so the searches are not affected by the representation.
+ *
+ *    A grid graph stores no edges at all: they are derived, when needed, from
+ *    the cell kinds in the info array given (see defs.h).
+ *
+ *    A finalized graph can be saved in a model file (see model.h), and mapped
+ *    back from it without copying its edges.
+ *
+ *    The searches keep their queues in a workspace, so the graph itself is
+ *    only read while searching and each thread can use its own workspace.
+ *
+ *    The trees of the garage (see tree.h) are made and repaired by
+ *    update_tree, whatever the format they are kept in.
+ *
+ *    Search trees can be repaired after vertices are blocked or opened, with
+ *    a cost proportional to the region affected.
  *
  */
 
@@ -19,19 +36,33 @@
 
 #include "defs.h"
 #include "LinkedList.h"
-#include "p_queue.h"
 #include "restriction.h"
+#include "model.h"
+#include "tree.h"
 
 typedef struct _graph graph;
+typedef struct _workspace workspace;
 
 /* graph: */
 graph* new_graph( int V );
+graph* new_grid_graph( int N , int M , int P , int *info );
 void destroy_graph( graph *g );
 int V_graph( graph *g );
 void insertE_graph( graph *g , int a , int b , int weight );
+void finalize_graph( graph *g );
+void save_graph( graph *g , FILE *fp );
+graph* map_graph( model *m , int N , int M , int P , int *info );
+
+/* workspace: */
+workspace* new_workspace( graph *g );
+void destroy_workspace( workspace *w );
 
 /* search: */
-void generate_spt( graph *g , int *info , int M , int N , int *spt , int *wt , int source );
-LinkedList* get_path( int vB , int *AtoB , int *BtoC );
+void generate_spt( graph *g , workspace *w , int *info , int M , int N , int *spt , int *wt , int source );
+void repair_spt( graph *g , workspace *w , int *info , int M , int N , int *spt , int *wt ,
+		 int source , int *changed , int n_changed );
+void update_tree( graph *g , workspace *w , int *info , int M , int N , tree *t ,
+		  int source , int *changed , int n_changed );
+int get_path( int vB , tree *AtoB , tree *BtoC , int **path , int *max_path );
 
 #endif
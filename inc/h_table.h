@@ -3,12 +3,13 @@
  *
  *  Authors: Miguel Malaca & Miguel Pinho
  *
- *  Description: C-implentation of an hash table, by list dispersion.
+ *  Description: C-implentation of an hash table, by open addressing.
  *
  *  Implementation details:
- *    The hash table, initialized wiyh a certain size and hash function, is 
- *    implemented by an array of lists. The elements givens are dispersed 
- *    using the hash fuction throughout the various lists.
+ *    The hash table, initialized with a certain size and hash function, is
+ *    implemented by an array of slots (Robin Hood hashing), that grows with
+ *    the number of elements. The hash function gives the full hash of a key,
+ *    which is kept with it, and not only its position.
  *
  */
 
@@ -16,11 +17,10 @@
 #define H_TABLE_H
 
 #include "defs.h"
-#include "LinkedList.h"
 
 typedef struct _h_table h_table;
 
-h_table* new_h_table( int size , int (*hash_function)(Item, int) , int (*compare_function)(Item, Item) , void (*free_item)(Item) );
+h_table* new_h_table( int size , unsigned long (*hash_function)(Item) , int (*compare_function)(Item, Item) , void (*free_item)(Item) );
 void destroy_h_table( h_table *ht );
 void clear_h_table( h_table *ht );
 void put_h_table( h_table *ht , Item this , Item key );
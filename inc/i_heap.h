@@ -0,0 +1,42 @@
+/*
+ *  File name: i_heap.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: C-Implementation of an indexed priority queue of the
+ *      integers 0 to n-1, each one with an integer key. Has functions to
+ *      insert, remove any of them, and access or remove the one with the
+ *      lowest key.
+ *
+ *  Implementation details:
+ *    D-ary heap, with the position of each integer in the heap kept in an
+ *    array, so any integer can be removed or have its key changed, and is
+ *    never in the heap twice. Equal keys are ordered by the integers
+ *    themselves. The number of children of each node is I_HEAP_D (4 unless
+ *    defined otherwise when compiling).
+ *
+ */
+
+#ifndef I_HEAP_H
+#define I_HEAP_H
+
+#include "defs.h"
+
+#ifndef I_HEAP_D
+#define I_HEAP_D 4
+#endif
+
+typedef struct _i_heap i_heap;
+
+i_heap* new_i_heap( int n );
+void destroy_i_heap( i_heap *h );
+void clear_i_heap( i_heap *h );
+void build_i_heap( i_heap *h , int *keys );
+void insert_i_heap( i_heap *h , int this , int key );
+void remove_i_heap( i_heap *h , int this );
+int pop_i_heap( i_heap *h );
+int min_i_heap( i_heap *h );
+int key_i_heap( i_heap *h , int this );
+int isEmpty_i_heap( i_heap *h );
+
+#endif
@@ -0,0 +1,35 @@
+/*
+ *  File name: lru.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: C-Implementation of a least recently used (LRU) cache of the
+ *      integers 0 to n-1, each one with a size, within a size budget. Has
+ *      functions to use an integer, to add and remove it, and to choose the
+ *      ones to evict.
+ *
+ *  Implementation details:
+ *    The cache only keeps which integers are in it, in the order they were
+ *    used, and their sizes: the caller keeps the things cached and frees them
+ *    when they are evicted. Counts the hits, misses and evictions.
+ *
+ */
+
+#ifndef LRU_H
+#define LRU_H
+
+#include "defs.h"
+
+typedef struct _lru lru;
+
+lru* new_lru( int n , long budget );
+void destroy_lru( lru *c );
+void set_budget_lru( lru *c , long budget );
+long budget_lru( lru *c );
+int use_lru( lru *c , int this );
+void insert_lru( lru *c , int this , long size );
+void remove_lru( lru *c , int this );
+int victim_lru( lru *c , long size );
+void stats_lru( lru *c , long *hits , long *misses , long *evictions );
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ *  File name: model.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Binary files with a garage already read and searched (its
+ *               model), loaded by mapping them in memory.
+ *
+ *  Implementation details:
+ *    A model file has a header (magic, version, and the hash and size of the
+ *    configuration file it was made from) and then a sequence of sections,
+ *    each with its size. The sections are read back in the order they were
+ *    written, and point straight into the mapped file, so nothing is parsed
+ *    or copied. The mapping is private: the arrays can be changed, but the
+ *    changes are never written to the file.
+ *
+ *    The files keep the native integer sizes and byte order, so they are
+ *    only meant for the machine that made them.
+ *
+ */
+
+#ifndef MODEL_H
+#define MODEL_H
+
+#include <stdio.h>
+
+typedef struct _model model;
+
+/* Description of the source of a model: hash and size of the configuration file. */
+typedef struct _model_key {
+  unsigned long hash;
+  long size;
+} model_key;
+
+/* reading: */
+model_key hash_data( char *data , size_t size );
+model* open_model( char *path , model_key key );
+void* read_model( model *m , size_t size );
+void release_model( void *data , size_t size );
+void destroy_model( model *m );
+
+/* writing: */
+FILE* create_model( char *path , model_key key );
+void write_model( FILE *fp , void *data , size_t size );
+int close_model( FILE *fp , char *path );
+
+#endif
@@ -3,11 +3,13 @@
  *
  *  Authors: Miguel Malaca & Miguel Pinho
  *
- *  Description: C-Implementation of a queue (FIFO)
+ *  Description: C-Implementation of a queue (FIFO), where an element can
+ *      also be removed from the middle, by the entry it was given.
  *
  *  Implementation details:
- *    The queue is implemented using a LinkedList, and pointer to the start and
- *    end of it. Insertion is done in the end and removal in the beginning.
+ *    The queue is implemented using a ring buffer. Insertion is done in the
+ *    end and removal in the beginning, or anywhere given the entry returned
+ *    by insert_queue, which lasts until the element leaves the queue.
  *
  */
 
@@ -15,16 +17,17 @@
 #define QUEUE_H
 
 #include "defs.h"
-#include "LinkedList.h"
 
 typedef struct _queue queue;
+typedef struct _q_entry q_entry;
 
-queue *new_queue( );
+queue *new_queue( void );
 void destroy_queue( queue *q , void (*freeItemFnt)(Item) );
 void clear_queue( queue *q , void (*freeItemFnt)(Item) );
 int isEmpty_queue( queue *q );
-void insert_queue( queue *q , Item this );
+q_entry *insert_queue( queue *q , Item this );
 Item remove_queue( queue *q );
+Item remove_entry_queue( queue *q , q_entry *e );
 Item peek_queue( queue *q );
 
 
@@ -8,10 +8,10 @@
  *    and applies them to the garage variables.
  *
  *  Implementation details:
- *    A group of LinkedLists was used for each type of restriction, has they
- *    they have different effects on the garage. Each restriction is represented
- *    by a start intant, an end instant and a value (its interpertation depends
- *    on the type, defined by where it is stored).
+ *    The restrictions are kept as a timeline of the instants when they start
+ *    and end, sorted once. Each update goes through the instants up to the
+ *    new one, and keeps the positions whose restriction changed, so they can
+ *    be applied (and the trees repaired) without looking at all of them.
  *
  */
 
@@ -19,13 +19,14 @@
 #define RESTRICT_H 
 
 #include "defs.h"
-#include "LinkedList.h"
+#include "scanner.h"
 
 typedef struct _restrict_data restrict_data;
 
-restrict_data *init_restrict( FILE *restrict_fp , int M , int N );
+restrict_data *init_restrict( scanner *restrict_in , int M , int N , int P );
 int update_restrict( restrict_data *r_data , int *t , int new_t );
-void apply_restrict_complete( restrict_data *r_data , int *info , int size_info , int *floor_flags , int size_ff );
+int *apply_restrict_complete( restrict_data *r_data , int *info , int size_info , int *floor_flags , int size_ff ,
+			      int *n_changed );
 void apply_restrict_parcial( restrict_data *r_data , int *floor_flags , int size_ff );
 void destroy_restrict( restrict_data *r_data );
 
@@ -0,0 +1,44 @@
+/*
+ *  File name: scanner.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Reading of the text files (configuration, cars and
+ *      restrictions) mapped in memory, a line at a time, with scanners for
+ *      the tokens, integers and characters of each line.
+ *
+ *  Implementation details:
+ *    The lines have no size limit. A token is given where it is in the
+ *    mapping, ended by a '\0' written over the blank after it (the mapping is
+ *    private, the file is never changed), so it lasts until the scanner is
+ *    closed. The file must be hashed (data_scanner) before it is scanned.
+ *
+ *    Only the blanks of a line are skipped before a token, an integer or a
+ *    character: a scan never goes into the next line.
+ *
+ *    A stream (the standard input or a named pipe) is read as its lines come,
+ *    with no end, and its tokens only last until the next line.
+ *
+ */
+
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <stddef.h>
+#include "defs.h"
+
+typedef struct _scanner scanner;
+
+scanner* open_scanner( char *path );
+scanner* stream_scanner( char *path );
+int tokens_last( scanner *s );
+void close_scanner( scanner *s );
+char* data_scanner( scanner *s , size_t *size );
+
+int next_line( scanner *s );
+char* scan_line( scanner *s , int *len );
+char* scan_token( scanner *s );
+int scan_int( scanner *s , int *x );
+int scan_char( scanner *s , char *c );
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ *  File name: slab.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: C-Implementation of a slab allocator: objects of a single
+ *      size, taken from large chunks. Has functions to allocate and free an
+ *      object, and to free all of them at once.
+ *
+ *  Implementation details:
+ *    The objects freed one by one are kept in a free list, and are the first
+ *    to be allocated again. Freeing all the objects at once (clear_slab or
+ *    destroy_slab) costs one free per chunk, and not one per object. A slab
+ *    must only be used by one thread at a time.
+ *
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+#include "defs.h"
+
+typedef struct _slab slab;
+
+slab* new_slab( size_t size );
+void destroy_slab( slab *s );
+void clear_slab( slab *s );
+void* alloc_slab( slab *s );
+void free_slab( slab *s , void *this );
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ *  File name: tree.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Storage of the search trees of the garage: the parent and
+ *               the weight of each cell, in full or packed.
+ *
+ *  Implementation details:
+ *    A full tree keeps the spt and wt arrays made by the searches (an int per
+ *    cell each). A packed tree keeps, for each cell, the move from it to its
+ *    parent in 3 bits (one of the 6 neighbours of a cell in the grid) and its
+ *    weight in 16 bits. The cells that do not fit (larger weights, or other
+ *    parents) are kept apart, so a packed tree gives back exactly the arrays
+ *    it was made from.
+ *
+ *    The searches work on the arrays: open_tree gives them (unpacking the
+ *    tree in the buffers given, if it is packed) and close_tree packs them
+ *    back. The parent and weight of single cells are read without unpacking.
+ *
+ */
+
+#ifndef TREE_H
+#define TREE_H
+
+#include <stdio.h>
+#include "model.h"
+
+typedef struct _tree tree;
+
+tree* new_tree( int N , int M , int P , int packed );
+void destroy_tree( tree *t );
+long bytes_tree( int N , int M , int P , int packed );
+int is_packed_tree( tree *t );
+int parent_tree( tree *t , int v );
+int weight_tree( tree *t , int v );
+void open_tree( tree *t , int **spt , int **wt , int *buf_spt , int *buf_wt , int load );
+void close_tree( tree *t , int *spt , int *wt );
+
+/* model: */
+void save_tree( tree *t , FILE *fp );
+tree* map_tree( model *m , int N , int M , int P );
+
+#endif
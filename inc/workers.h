@@ -0,0 +1,38 @@
+/*
+ *  File name: workers.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Computation of several search trees at the same time, by a
+ *               pool of threads.
+ *
+ *  Implementation details:
+ *    Each tree is a job: the arrays where it is kept and its source. The
+ *    workers take the jobs in order from a shared counter, each one with its
+ *    own workspace, since the graph is only read while searching. The trees
+ *    are the same whatever the number of workers.
+ *
+ */
+
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include "graph.h"
+
+/*
+ *  Data Type: spt_job
+ *  Description: Structure with:
+ *      1) Tree made or repaired.
+ *      2) Source of the tree.
+ */
+typedef struct _spt_job {
+  tree *t;
+  int source;
+} spt_job;
+
+void set_workers( int n );
+int get_workers( void );
+void run_spt_jobs( graph *g , workspace *w , int *info , int M , int N , spt_job *jobs ,
+		   int n_jobs , int *changed , int n_changed );
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ *  File name: writer.h
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Writing of the moves of the cars to the output file, through
+ *      a large buffer, with the integers converted by hand.
+ *
+ *  Implementation details:
+ *    Each move is a line "tag t x y z m". The lines are only in the file
+ *    after close_writer (or, for a stream, after end_event), which return -1
+ *    if they could not be written. The moves are
+ *    not checked (see tools/verify.c). A binary writer writes them as the
+ *    records of binfmt.h.
+ *
+ */
+
+#ifndef WRITER_H
+#define WRITER_H
+
+#include "defs.h"
+
+typedef struct _writer writer;
+
+writer* open_writer( char *path );
+writer* binary_writer( char *path , int N , int M );
+writer* stream_writer( int fd );
+int end_event( writer *w );
+void write_move( writer *w , char *vid , int tk , int pX , int pY , int pZ , char tm );
+int close_writer( writer *w );
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ *  File name: b_queue.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: C-Implementation of a bucket priority queue of integers
+ *      (Dial's algorithm). Has functions to insert an integer with an integer
+ *      key and extract the one with the lowest key.
+ *
+ *  Implementation details:
+ *    The queue has a circular array of buckets, one per key, and each bucket
+ *    is a FIFO array of integers. With n buckets, the keys inserted must be
+ *    between the last key removed and that key plus n-1, which is the case
+ *    of searches in graphs whose weights are smaller than n.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "b_queue.h"
+
+#define BUCKET_START_SIZE 64
+
+/*
+ *  Data Type: bucket (private)
+ *  Description: Structure with:
+ *      1) Array of the integers in the bucket.
+ *      2) Positions of the first and after the last integers, and array size.
+ */
+typedef struct _bucket {
+  int *data;
+  int start, end, size;
+} bucket;
+
+/*
+ *  Data Type: b_queue (semi-private)
+ *  Description: Structure with:
+ *      1) Number of buckets and the buckets array.
+ *      2) Key of the current bucket (the lowest key in the queue).
+ *      3) Number of integers in the queue.
+ */
+struct _b_queue {
+  int n_buckets;
+  bucket *buckets;
+  int key;
+  int n_elements;
+};
+
+/* Interface function: Initializes a new b_queue, with n_buckets different keys at a time. */
+b_queue* new_b_queue( int n_buckets )
+{
+  b_queue *new;
+  int i;
+
+  new = (b_queue*) malloc( sizeof(b_queue) );
+  mem_check(new);
+
+  new->n_buckets = n_buckets;
+  new->buckets = (bucket*) malloc( n_buckets * sizeof(bucket) );
+  mem_check(new->buckets);
+
+  for ( i = 0 ; i < n_buckets ; i++ ) {
+    new->buckets[i].size = BUCKET_START_SIZE;
+    new->buckets[i].data = (int*) malloc( BUCKET_START_SIZE * sizeof(int) );
+    mem_check(new->buckets[i].data);
+    new->buckets[i].start = new->buckets[i].end = 0;
+  }
+
+  new->key = 0;
+  new->n_elements = 0;
+
+  return new;
+}
+
+/* Interface function: Deallocates the whole b_queue. */
+void destroy_b_queue( b_queue *q )
+{
+  int i;
+
+  for ( i = 0 ; i < q->n_buckets ; i++ ) {
+    free( q->buckets[i].data );
+  }
+  free( q->buckets );
+  free( q );
+}
+
+/* Interface function: Empties the b_queue. */
+void clear_b_queue( b_queue *q )
+{
+  int i;
+
+  for ( i = 0 ; i < q->n_buckets ; i++ ) {
+    q->buckets[i].start = q->buckets[i].end = 0;
+  }
+
+  q->key = 0;
+  q->n_elements = 0;
+}
+
+/* Interface function: Insert a new integer with the key given. */
+void insert_b_queue( b_queue *q , int this , int key )
+{
+  bucket *b;
+
+  /* An empty queue accepts any key, and starts counting from it if it is out of the keys
+     allowed. Otherwise it keeps the last key removed: a search can empty the queue while
+     expanding a vertex, and then insert keys lower than the first one. */
+  if ( q->n_elements == 0 && (key < q->key || key >= q->key + q->n_buckets) )
+    q->key = key;
+
+  b = &(q->buckets[key % q->n_buckets]);
+
+  if ( b->end == b->size ) {
+    b->size *= 2;
+    b->data = (int*) realloc( b->data , b->size * sizeof(int) );
+    mem_check(b->data);
+  }
+
+  b->data[b->end++] = this;
+  q->n_elements++;
+}
+
+/* Interface function: remove and return the integer with the lowest key (first in, among equals). */
+int remove_b_queue( b_queue *q , int *key )
+{
+  bucket *b;
+
+  if ( q->n_elements == 0 )
+    return -1;
+
+  /* Advance to the next non empty bucket, emptying the ones already used. */
+  b = &(q->buckets[q->key % q->n_buckets]);
+  while ( b->start == b->end ) {
+    b->start = b->end = 0;
+    q->key++;
+    b = &(q->buckets[q->key % q->n_buckets]);
+  }
+
+  q->n_elements--;
+  *key = q->key;
+
+  return b->data[b->start++];
+}
+
+/* Interface function: check if the b_queue is empty. */
+int isEmpty_b_queue( b_queue *q )
+{
+  return ( q->n_elements == 0 );
+}
@@ -0,0 +1,161 @@
+/*
+ *  File name: binfmt.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Binary formats of the cars file (events) and of the output
+ *      file (results), with the varints and the table of tags they share.
+ *
+ *  Implementation details:
+ *    The table keeps the tags by number (a vector) and the numbers by tag (a
+ *    hash table). The one that writes a file owns the tags (copies them, as
+ *    they may not last); the one that reads a file points them where they
+ *    are in it.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "binfmt.h"
+#include "containers.h"
+
+unsigned long hash_tag( char *tag );
+
+#define tag_equal(a, b) (strcmp((a), (b)) == 0)
+
+DEFINE_VEC(name_vec, char*)
+DEFINE_HASHMAP(tag_ids, char*, int, hash_tag, tag_equal)
+
+/*
+ *  Data Type: tag_table (semi-private)
+ *  Description: Structure with:
+ *      1) Tags by number, and numbers by tag.
+ *      2) If the tags are copies, freed with the table.
+ */
+struct _tag_table {
+  name_vec names;
+  tag_ids ids;
+  int own;
+};
+
+/* Interface function: writes x as a varint at p, returning the position after it. */
+char* put_varint( char *p , unsigned long x )
+{
+  while ( x >= 0x80 ) {
+    *(p++) = (char) ((x & 0x7f) | 0x80);
+    x >>= 7;
+  }
+  *(p++) = (char) x;
+
+  return p;
+}
+
+/* Interface function: reads the varint at *p (before end) into x, moving *p past it.
+   Returns 0 if it is cut by the end, or too long. */
+int get_varint( char **p , char *end , unsigned long *x )
+{
+  unsigned char *q = (unsigned char*) *p;
+  int shift;
+
+  *x = 0;
+  for ( shift = 0 ; shift < 7 * MAX_VARINT && (char*) q < end ; shift += 7 ) {
+    *x |= (unsigned long) (*q & 0x7f) << shift;
+    if ( (*(q++) & 0x80) == 0 ) {
+      *p = (char*) q;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/* Interface function: returns the code of a move, or -1 if it is not one. */
+int move_code( char m )
+{
+  char *c = strchr( MOVE_CODES , m );
+
+  return ( m == '\0' || c == NULL ) ? -1 : (int) (c - MOVE_CODES);
+}
+
+/* Interface function: makes an empty table, that copies the tags added if own is set. */
+tag_table* new_tags( int own )
+{
+  tag_table *t;
+
+  t = (tag_table*) malloc( sizeof(tag_table) );
+  mem_check(t);
+
+  name_vec_init( &(t->names) );
+  tag_ids_init( &(t->ids) , H_TABLE_SIZE );
+  t->own = own;
+
+  return t;
+}
+
+/* Interface function: returns the number of a tag, or -1 if it is not in the table. */
+int find_tag( tag_table *t , char *tag )
+{
+  int *id = tag_ids_get( &(t->ids) , tag );
+
+  return id == NULL ? -1 : *id;
+}
+
+/* Interface function: adds a tag that is not in the table, returning its number. */
+int add_tag( tag_table *t , char *tag )
+{
+  char *name = tag;
+
+  if ( t->own ) {
+    name = (char*) malloc( strlen( tag ) + 1 );
+    mem_check(name);
+    strcpy( name , tag );
+  }
+
+  name_vec_push( &(t->names) , name );
+  tag_ids_put( &(t->ids) , name , t->names.n - 1 );
+
+  return t->names.n - 1;
+}
+
+/* Interface function: reads the tag of a record at *p (before end), moving *p past it. A new
+   tag is added as it is in the data, so the data must last as long as the table. Returns
+   NULL if the record is cut, or the number is not valid. */
+char* get_tag( tag_table *t , char **p , char *end )
+{
+  unsigned long id;
+  char *tag, *nul;
+
+  if ( !get_varint( p , end , &id ) || id > (unsigned long) t->names.n )
+    return NULL;
+  if ( id < (unsigned long) t->names.n )
+    return t->names.data[id];
+
+  tag = *p;
+  if ( (nul = (char*) memchr( tag , '\0' , end - tag )) == NULL )
+    return NULL;
+  *p = nul + 1;
+
+  add_tag( t , tag );
+  return tag;
+}
+
+/* Interface function: frees the table (and the tags, if they are copies). */
+void free_tags( tag_table *t )
+{
+  int i;
+
+  if ( t->own )
+    for ( i = 0 ; i < t->names.n ; i++ )
+      free( t->names.data[i] );
+
+  name_vec_free( &(t->names) );
+  tag_ids_free( &(t->ids) );
+  free( t );
+}
+
+/* Private. Hash function of the tags: FNV-1a, 32 bits. */
+unsigned long hash_tag( char *tag )
+{
+  return fnv1a( tag , strlen(tag) , FNV_OFFSET );
+}
@@ -0,0 +1,266 @@
+/*
+ *  File name: costs.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Park costs over dense arrays, indexed by park: the weight
+ *      from an entry, the weight to the nearest exit and a mask of the parks
+ *      that can be used.
+ *
+ *  Implementation details:
+ *    The cost of park i is wt_e[i] + COST_MULT * wt_a[i], when ok[i] is -1
+ *    (all bits set), and the park is ignored when ok[i] is 0 or one of its
+ *    weights is -1 (not reached). The loops are
+ *    vectorized with AVX2 or SSE4.1 when the processor has them (checked at
+ *    run time), and use plain C otherwise. All versions give the same result.
+ *
+ *    The argmin keeps, per lane, the lowest cost and the first park where it
+ *    was found. The lanes are then reduced by cost and, among equal costs,
+ *    by park, so the first park with the lowest cost is returned.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+#include "costs.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COSTS_SIMD
+#include <immintrin.h>
+#endif
+
+/* Kernel versions: not chosen yet, plain C, SSE4.1 and AVX2. */
+#define K_UNKNOWN 0
+#define K_SCALAR 1
+#define K_SSE4 2
+#define K_AVX2 3
+
+static int kernel = K_UNKNOWN;
+
+int get_kernel( void );
+void costs_scalar( int n , int *wt_e , int *wt_a , int *ok , int *cost , int first );
+int argmin_scalar( int n , int *wt_e , int *wt_a , int *ok , int first , int *min );
+int reduce_lanes( int *val , int *idx , int lanes , int *min );
+
+#ifdef COSTS_SIMD
+void costs_sse4( int n , int *wt_e , int *wt_a , int *ok , int *cost );
+void costs_avx2( int n , int *wt_e , int *wt_a , int *ok , int *cost );
+int argmin_sse4( int n , int *wt_e , int *wt_a , int *ok );
+int argmin_avx2( int n , int *wt_e , int *wt_a , int *ok );
+#endif
+
+/* Computes the cost of the n parks, -1 for the ones that can not be used. */
+void costs_park( int n , int *wt_e , int *wt_a , int *ok , int *cost )
+{
+#ifdef COSTS_SIMD
+  switch ( get_kernel() ) {
+  case K_AVX2:
+    costs_avx2( n , wt_e , wt_a , ok , cost );
+    return;
+  case K_SSE4:
+    costs_sse4( n , wt_e , wt_a , ok , cost );
+    return;
+  }
+#endif
+  costs_scalar( n , wt_e , wt_a , ok , cost , 0 );
+}
+
+/* Returns the first of the n parks with the lowest cost, or -1 if none can be used. */
+int argmin_park( int n , int *wt_e , int *wt_a , int *ok )
+{
+  int min;
+
+#ifdef COSTS_SIMD
+  switch ( get_kernel() ) {
+  case K_AVX2:
+    return argmin_avx2( n , wt_e , wt_a , ok );
+  case K_SSE4:
+    return argmin_sse4( n , wt_e , wt_a , ok );
+  }
+#endif
+  return argmin_scalar( n , wt_e , wt_a , ok , 0 , &min );
+}
+
+/* Private. Chooses the kernel version, the first time it is needed. */
+int get_kernel( void )
+{
+  if ( kernel == K_UNKNOWN ) {
+    kernel = K_SCALAR;
+#ifdef COSTS_SIMD
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports("avx2") )
+      kernel = K_AVX2;
+    else if ( __builtin_cpu_supports("sse4.1") )
+      kernel = K_SSE4;
+#endif
+  }
+
+  return kernel;
+}
+
+/* Private. Plain C costs, from park first on. */
+void costs_scalar( int n , int *wt_e , int *wt_a , int *ok , int *cost , int first )
+{
+  int i;
+
+  for ( i = first ; i < n ; i++ ) {
+    cost[i] = ok[i] && (wt_e[i] | wt_a[i]) >= 0 ? wt_e[i] + COST_MULT * wt_a[i] : -1;
+  }
+}
+
+/* Private. Plain C argmin, from park first on. The lowest cost is kept in min (INT_MAX if none). */
+int argmin_scalar( int n , int *wt_e , int *wt_a , int *ok , int first , int *min )
+{
+  int i, c, best = -1;
+
+  *min = INT_MAX;
+  for ( i = first ; i < n ; i++ ) {
+    if ( !ok[i] || (wt_e[i] | wt_a[i]) < 0 )
+      continue;
+
+    c = wt_e[i] + COST_MULT * wt_a[i];
+    if ( c < *min ) {
+      *min = c;
+      best = i;
+    }
+  }
+
+  return best;
+}
+
+/* Private. Reduces the lowest cost and its park of each lane to the first park with the
+   lowest cost of all. Lanes without parks have INT_MAX. */
+int reduce_lanes( int *val , int *idx , int lanes , int *min )
+{
+  int l, best = -1;
+
+  *min = INT_MAX;
+  for ( l = 0 ; l < lanes ; l++ ) {
+    if ( val[l] == INT_MAX )
+      continue;
+
+    if ( val[l] < *min || (val[l] == *min && idx[l] < best) ) {
+      *min = val[l];
+      best = idx[l];
+    }
+  }
+
+  return best;
+}
+
+#ifdef COSTS_SIMD
+
+__attribute__((target("sse4.1")))
+void costs_sse4( int n , int *wt_e , int *wt_a , int *ok , int *cost )
+{
+  __m128i e, a, m, c, none = _mm_set1_epi32(-1);
+  int i;
+
+  for ( i = 0 ; i + 4 <= n ; i += 4 ) {
+    e = _mm_loadu_si128( (__m128i*) (wt_e + i) );
+    a = _mm_loadu_si128( (__m128i*) (wt_a + i) );
+    m = _mm_loadu_si128( (__m128i*) (ok + i) );
+    m = _mm_and_si128( m , _mm_cmpgt_epi32( _mm_or_si128( e , a ) , none ) );
+    c = _mm_add_epi32( e , _mm_mullo_epi32( a , _mm_set1_epi32(COST_MULT) ) );
+    _mm_storeu_si128( (__m128i*) (cost + i) , _mm_blendv_epi8( none , c , m ) );
+  }
+
+  costs_scalar( n , wt_e , wt_a , ok , cost , i );
+}
+
+__attribute__((target("avx2")))
+void costs_avx2( int n , int *wt_e , int *wt_a , int *ok , int *cost )
+{
+  __m256i e, a, m, c, none = _mm256_set1_epi32(-1);
+  int i;
+
+  for ( i = 0 ; i + 8 <= n ; i += 8 ) {
+    e = _mm256_loadu_si256( (__m256i*) (wt_e + i) );
+    a = _mm256_loadu_si256( (__m256i*) (wt_a + i) );
+    m = _mm256_loadu_si256( (__m256i*) (ok + i) );
+    m = _mm256_and_si256( m , _mm256_cmpgt_epi32( _mm256_or_si256( e , a ) , none ) );
+    c = _mm256_add_epi32( e , _mm256_mullo_epi32( a , _mm256_set1_epi32(COST_MULT) ) );
+    _mm256_storeu_si256( (__m256i*) (cost + i) , _mm256_blendv_epi8( none , c , m ) );
+  }
+
+  costs_scalar( n , wt_e , wt_a , ok , cost , i );
+}
+
+__attribute__((target("sse4.1")))
+int argmin_sse4( int n , int *wt_e , int *wt_a , int *ok )
+{
+  __m128i e, a, m, c, lt, val, idx, cur, four, none = _mm_set1_epi32(-1);
+  int v[4], x[4], i, best, min, tail, tail_min;
+
+  val = _mm_set1_epi32( INT_MAX );
+  idx = _mm_set1_epi32( -1 );
+  cur = _mm_setr_epi32( 0 , 1 , 2 , 3 );
+  four = _mm_set1_epi32( 4 );
+
+  for ( i = 0 ; i + 4 <= n ; i += 4 ) {
+    e = _mm_loadu_si128( (__m128i*) (wt_e + i) );
+    a = _mm_loadu_si128( (__m128i*) (wt_a + i) );
+    m = _mm_loadu_si128( (__m128i*) (ok + i) );
+    m = _mm_and_si128( m , _mm_cmpgt_epi32( _mm_or_si128( e , a ) , none ) );
+    c = _mm_add_epi32( e , _mm_mullo_epi32( a , _mm_set1_epi32(COST_MULT) ) );
+    c = _mm_blendv_epi8( _mm_set1_epi32(INT_MAX) , c , m );
+
+    /* Only a lower cost replaces the one of the lane, so it keeps its first park. */
+    lt = _mm_cmplt_epi32( c , val );
+    val = _mm_blendv_epi8( val , c , lt );
+    idx = _mm_blendv_epi8( idx , cur , lt );
+    cur = _mm_add_epi32( cur , four );
+  }
+
+  _mm_storeu_si128( (__m128i*) v , val );
+  _mm_storeu_si128( (__m128i*) x , idx );
+  best = reduce_lanes( v , x , 4 , &min );
+
+  /* The parks left come after all the others. */
+  tail = argmin_scalar( n , wt_e , wt_a , ok , i , &tail_min );
+  if ( tail_min < min )
+    best = tail;
+
+  return best;
+}
+
+__attribute__((target("avx2")))
+int argmin_avx2( int n , int *wt_e , int *wt_a , int *ok )
+{
+  __m256i e, a, m, c, lt, val, idx, cur, eight, none = _mm256_set1_epi32(-1);
+  int v[8], x[8], i, best, min, tail, tail_min;
+
+  val = _mm256_set1_epi32( INT_MAX );
+  idx = _mm256_set1_epi32( -1 );
+  cur = _mm256_setr_epi32( 0 , 1 , 2 , 3 , 4 , 5 , 6 , 7 );
+  eight = _mm256_set1_epi32( 8 );
+
+  for ( i = 0 ; i + 8 <= n ; i += 8 ) {
+    e = _mm256_loadu_si256( (__m256i*) (wt_e + i) );
+    a = _mm256_loadu_si256( (__m256i*) (wt_a + i) );
+    m = _mm256_loadu_si256( (__m256i*) (ok + i) );
+    m = _mm256_and_si256( m , _mm256_cmpgt_epi32( _mm256_or_si256( e , a ) , none ) );
+    c = _mm256_add_epi32( e , _mm256_mullo_epi32( a , _mm256_set1_epi32(COST_MULT) ) );
+    c = _mm256_blendv_epi8( _mm256_set1_epi32(INT_MAX) , c , m );
+
+    /* Only a lower cost replaces the one of the lane, so it keeps its first park. */
+    lt = _mm256_cmpgt_epi32( val , c );
+    val = _mm256_blendv_epi8( val , c , lt );
+    idx = _mm256_blendv_epi8( idx , cur , lt );
+    cur = _mm256_add_epi32( cur , eight );
+  }
+
+  _mm256_storeu_si256( (__m256i*) v , val );
+  _mm256_storeu_si256( (__m256i*) x , idx );
+  best = reduce_lanes( v , x , 8 , &min );
+
+  /* The parks left come after all the others. */
+  tail = argmin_scalar( n , wt_e , wt_a , ok , i , &tail_min );
+  if ( tail_min < min )
+    best = tail;
+
+  return best;
+}
+
+#endif
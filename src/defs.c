@@ -22,3 +22,17 @@ void print_int( Item a , FILE *fp )
 {
   fprintf( fp , "%d-" , *((int*) a) );
 }
+
+/* FNV-1a hash (32 bits) of size bytes, going on from seed: FNV_OFFSET to start a hash, or
+   the hash of the bytes before these. */
+unsigned long fnv1a( const void *data , size_t size , unsigned long seed )
+{
+  const unsigned char *c = (const unsigned char*) data;
+  size_t i;
+
+  for ( i = 0 ; i < size ; i++ ) {
+    seed = ((seed ^ c[i]) * 16777619UL) & 0xffffffffUL;
+  }
+
+  return seed;
+}
@@ -0,0 +1,187 @@
+/*
+ *  File name: events.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Reading of the cars file, a car event at a time, in text
+ *      ("tag t type x y z", a line each) or in the binary format of binfmt.h.
+ *
+ *  Implementation details:
+ *    Both are read through a scanner: the text a line at a time, and the
+ *    binary from its contents (mapped), with the tags where they are in it.
+ *    A stream is always text.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "events.h"
+#include "binfmt.h"
+
+/*
+ *  Data Type: events (semi-private)
+ *  Description: Structure with:
+ *      1) Scanner of the file, and its path (for the errors).
+ *      2) For the binary format: the position and the end of the records,
+ *         the tags so far, and the instant of the last event.
+ */
+struct _events {
+  scanner *in;
+  char *path;
+  char *pos, *end;
+  tag_table *tags;
+  int t;
+};
+
+int next_text( events *ev , car_event *e );
+int next_binary( events *ev , car_event *e );
+int read_record( events *ev , car_event *e );
+
+/* Interface function: opens the cars file in the path given, in either format. Returns NULL
+   if it cannot be opened. */
+events* open_events( char *path )
+{
+  events *ev;
+  scanner *in;
+  char *data;
+  size_t size;
+
+  if ( (in = open_scanner( path )) == NULL )
+    return NULL;
+
+  ev = (events*) malloc( sizeof(events) );
+  mem_check(ev);
+
+  ev->in = in;
+  ev->path = path;
+  ev->tags = NULL;
+  ev->t = 0;
+
+  data = data_scanner( in , &size );
+  if ( size >= MAGIC_SIZE && memcmp( data , EVENTS_MAGIC , MAGIC_SIZE ) == 0 ) {
+    ev->pos = data + MAGIC_SIZE;
+    ev->end = data + size;
+    ev->tags = new_tags( 0 );
+  }
+
+  return ev;
+}
+
+/* Interface function: reads the cars from the named pipe in the path given (or the standard
+   input, if it is NULL), in text. Returns NULL if it cannot be opened. */
+events* stream_events( char *path )
+{
+  events *ev;
+  scanner *in;
+
+  if ( (in = stream_scanner( path )) == NULL )
+    return NULL;
+
+  ev = (events*) malloc( sizeof(events) );
+  mem_check(ev);
+
+  ev->in = in;
+  ev->path = path;
+  ev->tags = NULL;
+  ev->t = 0;
+
+  return ev;
+}
+
+/* Interface function: returns 1 if the file is in the binary format. */
+int binary_events( events *ev )
+{
+  return ev->tags != NULL;
+}
+
+/* Interface function: returns 1 if the tags last until the file is closed, or 0 if they only
+   last until the next event (a stream). */
+int tags_last( events *ev )
+{
+  return tokens_last( ev->in );
+}
+
+/* Interface function: reads the next event into e. Returns 0 at the end of the file (or at
+   the first record of a binary file that is not valid). */
+int next_event( events *ev , car_event *e )
+{
+  return binary_events( ev ) ? next_binary( ev , e ) : next_text( ev , e );
+}
+
+/* Interface function: closes the file. The tags given are no longer valid. */
+void close_events( events *ev )
+{
+  if ( ev->tags != NULL )
+    free_tags( ev->tags );
+  close_scanner( ev->in );
+
+  free( ev );
+}
+
+/* Private. Reads the next line with a tag and an instant. */
+int next_text( events *ev , car_event *e )
+{
+  scanner *in = ev->in;
+
+  while ( next_line( in ) ) {
+    if ( (e->tag = scan_token( in )) == NULL || !scan_int( in , &(e->t) ) )
+      continue;
+
+    e->fields = 1;
+    if ( scan_char( in , &(e->type) ) )
+      for ( e->fields = 2 ; e->fields < 5 && scan_int( in , &(e->pos[e->fields - 2]) ) ; e->fields++ );
+
+    return 1;
+  }
+
+  return 0;
+}
+
+/* Private. Reads the next record. */
+int next_binary( events *ev , car_event *e )
+{
+  if ( ev->pos == ev->end )
+    return 0;
+
+  if ( !read_record( ev , e ) ) {
+    fprintf(stderr, "Invalid record in file %s.\n", ev->path);
+    ev->pos = ev->end;
+    return 0;
+  }
+
+  return 1;
+}
+
+/* Private. Decodes the record at the position into e. Returns 0 if it is not valid. */
+int read_record( events *ev , car_event *e )
+{
+  unsigned long u;
+  int i, n;
+
+  if ( (e->tag = get_tag( ev->tags , &(ev->pos) , ev->end )) == NULL
+       || !get_varint( &(ev->pos) , ev->end , &u ) || ev->end - ev->pos < 2 )
+    return 0;
+
+  ev->t += (int) unzigzag(u);
+  e->t = ev->t;
+
+  n = (unsigned char) ev->pos[1];
+  if ( n > 3 )
+    return 0;
+
+  e->fields = 1;
+  if ( ev->pos[0] != '\0' ) {
+    e->type = ev->pos[0];
+    e->fields = 2 + n;
+  }
+  ev->pos += 2;
+
+  for ( i = 0 ; i < n ; i++ ) {
+    if ( !get_varint( &(ev->pos) , ev->end , &u ) )
+      return 0;
+    e->pos[i] = (int) unzigzag(u);
+  }
+
+  return 1;
+}
@@ -10,6 +10,13 @@
  *    to read and create the garage, destroy the garage, process the input files
  *    and generate the output file.
  *
+ *    A garage just read can be saved as a model (see model.h). A garage made
+ *    from a model keeps the arrays that are large or slow to make (info, the
+ *    edges, the trees and the park ranks) in the mapped file.
+ *
+ *    The trees of large garages are packed (see tree.h), and only read a cell
+ *    at a time, outside of the searches.
+ *
  */
 
 #include <stdlib.h>
@@ -17,27 +24,72 @@
 #include <string.h>
 
 #include "garage.h"
+#include "workers.h"
+#include "i_heap.h"
+#include "costs.h"
+#include "lru.h"
+#include "slab.h"
+#include "containers.h"
 
 #define NUM_IDS 8
-#define MAX_ID_SIZE 128
 
 static const int ids[] = { EMPTY , INVALID , PARK_PLACE_E , PARK_PLACE_O ,
 			   INVALID , INVALID , UP , DOWN };
+static const int kinds[] = { CELL_FREE , CELL_WALL , CELL_STOP , CELL_STOP ,
+			     CELL_STOP , CELL_STOP , CELL_RAMP , CELL_FREE };
 static const char symbols[] = { ' ' , '@' , '.' , 'x' , 'e' , 'a' , 'u' , 'd' };
 
+/* Above this number of cells, the graph edges are not stored (GRAPH_AUTO). */
+#define GRID_GRAPH_SIZE (1 << 20)
+
+/* Above this number of cells, the trees are packed (TREE_AUTO). */
+#define PACKED_TREE_SIZE (1 << 20)
+
+/* If more than 1/REPAIR_LIMIT of the cells change, the trees are made again instead of repaired. */
+#define REPAIR_LIMIT 64
+
+/* Park cells and exits are kept in vectors, and the parked cars by tag in a hash table, as
+   the first of the waiting cars with each tag. */
+#define tag_equal(a, b) (strcmp((a), (b)) == 0)
+
+DEFINE_VEC(int_vec, int)
+DEFINE_HASHMAP(car_map, char*, p_car*, car_function, tag_equal)
+DEFINE_HASHMAP(wait_map, char*, car*, car_function, tag_equal)
+
 struct _garage {
   graph *garage_graph;
+  workspace *ws;
+  int graph_type, tree_type;
   int M, N, P, A, E;
   access *entries;
-  LinkedList *exits[5];
+  int_vec exits[5];
+  tree **exit_trees[5];
   int* info;
   restrict_data *r_data;
   int valid_exit[5];
   int *valid_entry;
-  h_table *parked_cars;
+  car_map parked_cars;
   int empty_parks;
-  LinkedList **park_spaces;
+  int_vec *park_spaces;
   int* valid_floors;
+  int *path, max_path;
+  int n_parks;
+  int *park_cell;
+  int *park_rank;
+  int *park_keys;
+  i_heap **park_index;
+  char *valid_index;
+  int *park_wt;
+  char *valid_wt;
+  int *park_ok;
+  int valid_ok;
+  model *mapped;
+  lru *trees;
+  /* The car records come from these slabs. Their tags are where they were read, in the
+     mapping of the cars file, which is kept until the garage is destroyed, unless the cars
+     come from a stream: then each record has its own copy (own_tags). */
+  slab *cars, *p_cars;
+  int own_tags;
 };
 
 struct _p_car{
@@ -45,33 +97,63 @@ struct _p_car{
   int index_park ;
 };
 
+/* A waiting car keeps its entry in the queue, and the next car waiting with its tag. */
 struct _car{
   char* tag;
   int index_entry, exit_code, t;
+  q_entry *entry;
+  car *same_tag;
 };
 
 struct _access{
   char* name;
   int index;
-  int* spt;
-  int* wt;
+  tree* t;
 };
 
-int car_function(Item c1, int size);
-int compare_car(Item c1, Item c2);
-void destroy_access( Item a );
-void destroy_p_car( Item p );
-void destroy_car( Item c );
-
-void read_line(char *row, int n, FILE *fp) {
-
-  if ( fgets(row, n, fp) == NULL ) {
+void destroy_p_car( garage *g , p_car *p );
+void destroy_car( garage *g , car *c );
+car* new_car( garage *g , char *tag );
+p_car* new_p_car( garage *g , char *tag , int index_park );
+char* copy_tag( char *tag );
+void wait_car( wait_map *m , queue *q , car *c );
+car* leave_queue( wait_map *m , queue *q , char *tag );
+void repair_trees( garage *g , int *changed , int n );
+int tree_touched( garage *g , tree *t , int source , int *changed , int n_changed );
+void order_exits( garage *g );
+void update_all_trees( garage *g );
+int exit_weight( garage *g , int type , int cell , int *k );
+void run_trees( garage *g , int valid , int *changed , int n_changed );
+void make_park_ranks( garage *g );
+void alloc_garage( garage *g );
+int graph_kind( garage *g );
+int tree_kind( garage *g );
+void alloc_park_index( garage *g );
+tree** tree_slot( garage *g , int col );
+int n_trees( garage *g , int col );
+void load_tree( garage *g , int col , tree **t );
+void drop_tree( garage *g , int col );
+void use_tree( garage *g , int col );
+void load_all_trees( garage *g );
+i_heap* get_park_index( garage *g , int ie , int type );
+int best_park( garage *g , int ie , int type );
+int* park_weights( garage *g , int col );
+int* park_mask( garage *g );
+void invalidate_weights( garage *g );
+int park_cost( garage *g , int ie , int type , int cell );
+int park_usable( garage *g , int cell );
+void invalidate_index( garage *g );
+void occupy_park( garage *g , int cell );
+void free_park( garage *g , int cell );
+
+/* Starts the next line of the configuration file, which must be there. */
+void read_line( scanner *in )
+{
+  if ( !next_line( in ) ) {
     /* Error reading file. */
     fprintf(stderr, "Error reading *.cfg file. \n");
     exit(0);
-  } 
-
-  return;
+  }
 }
 
 int convert_type (char type)
@@ -88,39 +170,76 @@ int convert_type (char type)
     return 4;
 }
 
-void read_dimensions( FILE* fp , garage* g )
+void read_dimensions( scanner* in , garage* g )
 {
-  char aux[LINE_SIZE];
-  int size, i;
-
-  if ( fgets(aux, LINE_SIZE, fp) == NULL ) {
-    /* The compiler, with the flags -O3 and -ansi, had a warning for not evaluating the fgets return value. */
+  int size;
 
-    /* Error reading file. */
-    fprintf(stderr, "Error reading *.cfg file. \n");
-    exit(0);
-  } 
-  sscanf( aux, "%d %d %d %d %d" , &g->N, &g->M, &g->P, &g->E , &g->A );
+  read_line( in );
+  scan_int( in , &g->N );
+  scan_int( in , &g->M );
+  scan_int( in , &g->P );
+  scan_int( in , &g->E );
+  scan_int( in , &g->A );
 
   size = g->N * g->M * g->P;
-  g->garage_graph = new_graph( size );
-  g->entries = (access*) malloc( g->E * sizeof(access));
   g->info = (int*) malloc( size * sizeof(int));
-  g->park_spaces = (LinkedList**) malloc(g->P * sizeof(LinkedList*));
+  if ( graph_kind( g ) == GRAPH_GRID ) {
+    /* The connections are derived from the info array (filled by read_map). */
+    g->garage_graph = new_grid_graph( g->N , g->M , g->P , g->info );
+  } else {
+    g->garage_graph = new_graph( size );
+  }
+  alloc_garage( g );
+}
+
+/* Graph representation used for the garage: the one asked, or the one fit for its size. */
+int graph_kind( garage *g )
+{
+  if ( g->graph_type == GRAPH_GRID ||
+       (g->graph_type == GRAPH_AUTO && g->N * g->M * g->P > GRID_GRAPH_SIZE) )
+    return GRAPH_GRID;
+  return GRAPH_CSR;
+}
+
+/* Format of the trees of the garage: the one asked, or the one fit for its size. */
+int tree_kind( garage *g )
+{
+  if ( g->tree_type == TREE_PACKED ||
+       (g->tree_type == TREE_AUTO && g->N * g->M * g->P > PACKED_TREE_SIZE) )
+    return TREE_PACKED;
+  return TREE_FULL;
+}
+
+/* Allocates the accesses and the floors of a garage with its dimensions read. */
+void alloc_garage( garage *g )
+{
+  int i;
+
+  g->entries = (access*) malloc( g->E * sizeof(access));
+  g->park_spaces = (int_vec*) malloc(g->P * sizeof(int_vec));
   g->valid_floors = (int*) malloc(g->P * sizeof(int));
   g->valid_entry = (int*) malloc( g->E * sizeof(int));
+  g->parked_cars.slots = NULL;
+  g->cars = new_slab( sizeof(car) );
+  g->p_cars = new_slab( sizeof(p_car) );
+  g->own_tags = 0;
+  g->trees = new_lru( g->E + 5 , 0 );
+  g->max_path = 64;
+  g->path = (int*) malloc( g->max_path * sizeof(int) );
+  mem_check(g->path);
   g->empty_parks = 0;
   for(i = 0; i < 5; i++){
-    g->exits[i] = initLinkedList();
+    int_vec_init( &(g->exits[i]) );
+    g->exit_trees[i] = NULL;
     g->valid_exit[i] = 0;
   }
   for(i = 0; i < g->E; i++){
     g->valid_entry[i] = 0;
-    g->entries[i].spt = NULL;
-    g->entries[i].wt = NULL;
+    g->entries[i].name = NULL;
+    g->entries[i].t = NULL;
   }
   for(i = 0; i < g->P; i++){
-    g->park_spaces[i] = initLinkedList();
+    int_vec_init( &(g->park_spaces[i]) );
     g->valid_floors[i] = 0;
   }
 }
@@ -133,102 +252,96 @@ int get_identifier( char symbol )
      Return its code if there is a match. */
   for ( i = 0 ; i < NUM_IDS ; i++ ) {
     if ( symbol == symbols[i] )
-      return ids[i];
+      return new_id( ids[i] , kinds[i] );
   }
 
-  return INVALID;  /* If the symbol is not known, considers it a wall. */
+  /* If the symbol is not known, considers it a wall (but it is connected as a free cell). */
+  return new_id( INVALID , CELL_FREE );
 }
 
 /*Function responsible for reading and linking the vertexes of the graph
 Based on the idea that teachers used on the Invididual Evaluation: 
-read one line and save the line before, then comparing the adjacencies*/
+read one line, then comparing the adjacencies with the cells already read
+(the line before and the column before). The cell kinds decide the links.*/
 
-void read_map (garage *g , FILE* fp, int floor )
+void read_map (garage *g , scanner* in, int floor )
 {
 
-  char* row, *last_row, *tmp;
-  int i, j, index;
-  row = (char*) malloc( (g->N +2) * sizeof(char));
-  last_row = (char*) malloc( (g->N + 2) * sizeof(char));
+  char *row, symbol;
+  int i, j, index, kind, len;
 
   for ( i = g->M-1  ; i >= 0 ; i-- ){
-    read_line( row , g->N+2 , fp );
+    read_line( in );
+    row = scan_line( in , &len );
     for( j = 0 ; j < g->N ; j++ ){
       index = get_index(j, i, floor, g->M, g->N);
 
-      g->info[index] = get_identifier( row[j] );
+      /* A short line is ended by unknown symbols. */
+      symbol = j < len ? row[j] : '\0';
+      g->info[index] = get_identifier( symbol );
+      kind = get_kind( g->info[index] );
 
       /* Don't link two vertex if one of them is a wall */
-      if( row[j] != '@' ) {
+      if( kind != CELL_WALL ) {
 	
-	/* Don't look after the first line of the file */ 
-	if( i != g->M-1 && last_row[j] != '@'){
-	  
-	  /* Don't link two vertex if they're a combination of accesses, entries or parks */
-	  if(!((last_row[j] == '.' || last_row[j] == 'x' || last_row[j] == 'a' ||last_row[j] == 'e' ) && (row[j] == '.' || row[j] == 'x' || row[j] == 'a' || row[j] == 'e')))
-	    insertE_graph( g->garage_graph , index , get_index(j, i+1, floor, g->M, g->N) , 1);
-	}
+	/* Don't look after the first line of the file.
+	   Don't link two vertex if they're a combination of accesses, entries or parks */ 
+	if( i != g->M-1 && linked_kinds(kind, get_kind(g->info[index + g->N])) )
+	  insertE_graph( g->garage_graph , index , index + g->N , 1);
 	
 	/* Don't look after the first column of the file */
-	if( j != 0 && row[j-1] != '@'  ){
-	  if(!((row[j-1] == '.' || row[j-1] == 'x' || row[j-1] == 'a' || row[j-1] == 'e') && (row[j] == '.' || row[j] == 'x' || row[j] == 'a' || row[j] == 'e')))
-	    insertE_graph( g->garage_graph , index , get_index(j-1, i, floor, g->M, g->N) , 1);
-	}
+	if( j != 0 && linked_kinds(kind, get_kind(g->info[index - 1])) )
+	  insertE_graph( g->garage_graph , index , index - 1 , 1);
 	
 	/* Link ups to downs */
-	if (row[j] == 'u'){
+	if (kind == CELL_RAMP && floor + 1 < g->P){
 	  insertE_graph( g->garage_graph , index , get_index(j, i, floor+1, g->M, g->N) , 2);
 	}
-	if (row[j] == '.'){
+	if (symbol == '.'){
 	  g->empty_parks++;
 	}
 	/* Save a park's list per floor */
-	if (row[j] == '.' || row[j] == 'x'){
-	  g->park_spaces[floor] = insertUnsortedLinkedList(g->park_spaces[floor], new_int(index));
+	if (symbol == '.' || symbol == 'x'){
+	  int_vec_push( &(g->park_spaces[floor]) , index );
 	}
       }
       
     }
-    
-    tmp = last_row;
-    last_row = row;
-    row = tmp;
   }
-  free(row);
-  free(last_row);
 }
 
 /* Read the positions, names and types of the accesses of the map: entries and exits*/
-void read_accesses ( garage* g, FILE* fp, int* ec)
-{
-  int  x, y, z;
-  char aux[LINE_SIZE];
-  char type;
-  char tag[LINE_SIZE];
-
-  while( fgets(aux, LINE_SIZE, fp) != NULL && aux[0] != '+' ) {
-    sscanf( aux, "%s %d %d %d %c" , tag, &x, &y , &z , &type);
-      if (aux[0] == 'E') {
-	g->entries[*ec].wt = (int*) malloc( (g->M * g->N * g->P) * sizeof(int));
-	g->entries[*ec].spt = (int*) malloc( (g->M * g->N * g->P) * sizeof(int));
+void read_accesses ( garage* g, scanner* in, int* ec)
+{
+  int  x = 0, y = 0, z = 0;
+  char type = 0;
+  char *tag;
+
+  /* The accesses end at a '+' (or the end of the file). Blank lines are skipped. */
+  while( next_line( in ) ) {
+    if ( (tag = scan_token( in )) == NULL )
+      continue;
+    if ( tag[0] == '+' )
+      break;
+    scan_int( in , &x );
+    scan_int( in , &y );
+    scan_int( in , &z );
+    scan_char( in , &type );
+      if (tag[0] == 'E') {
+	g->entries[*ec].t = NULL;
 	g->entries[*ec].index = get_index(x, y, z, g->M, g->N);
 	g->entries[*ec].name = (char*) malloc((strlen(tag) + 1) * sizeof(char));
 	strcpy(g->entries[*ec].name, tag);
 	*ec+=1;
-      } else if(aux[0] == 'A') {
-	access* a = (access*) malloc(sizeof(access));
-	a->wt = (int*) malloc( (g->M * g->N * g->P) * sizeof(int));
-	a->spt = (int*) malloc( (g->M * g->N * g->P) * sizeof(int));
-	a->name = (char*) malloc((strlen(tag) + 1) * sizeof(char));
-	strcpy(a->name, tag);
-	a->index = get_index(x, y, z, g->M, g->N);
-	g->exits[convert_type(type)] = insertUnsortedLinkedList(g->exits[convert_type(type)], (Item) a);
+      } else if(tag[0] == 'A') {
+	/* The exits are kept by type, and get their trees when all are read. */
+	int_vec_push( &(g->exits[convert_type(type)]) , get_index(x, y, z, g->M, g->N) );
       }
   }
 }
 
 /* Iterface function: process the configure file and create garage. */
-garage* read_entryfile( FILE* fp )
+garage* read_entryfile( scanner* in , int graph_type , int tree_type )
 {
 
   int floor = 0, ecounter = 0;
@@ -236,23 +349,171 @@ garage* read_entryfile( FILE* fp )
   garage* g = (garage*) malloc (sizeof(garage));
   mem_check(g);
 
-  read_dimensions( fp , g );
+  g->graph_type = graph_type;
+  g->tree_type = tree_type;
+  g->mapped = NULL;
+
+  read_dimensions( in , g );
 
   for( floor = 0 ; floor < g->P ; floor ++){
 
-    read_map( g , fp , floor );
+    read_map( g , in , floor );
 
-    read_accesses( g , fp, &ecounter);
+    read_accesses( g , in, &ecounter);
 
   }
 
+  /* All edges were read, pack them for the searches. */
+  finalize_graph( g->garage_graph );
+
+  order_exits( g );
+  make_park_ranks( g );
+  g->ws = new_workspace( g->garage_graph );
+
+  return g;
+}
+
+/* Interface function: writes the model of a garage just read, with the trees made without
+   restrictions, to the path given. Returns 0 if it could not be written. */
+int save_garage( garage *g , char *path , model_key key )
+{
+  FILE *fp;
+  int dims[8], i, k;
+
+  fp = create_model( path , key );
+  if ( fp == NULL )
+    return 0;
+
+  load_all_trees( g );
+  update_all_trees( g );
+
+  dims[0] = g->N;
+  dims[1] = g->M;
+  dims[2] = g->P;
+  dims[3] = g->E;
+  dims[4] = g->A;
+  dims[5] = g->empty_parks;
+  dims[6] = graph_kind( g );
+  dims[7] = tree_kind( g );
+  write_model( fp , dims , sizeof(dims) );
+  write_model( fp , g->info , g->N * g->M * g->P * sizeof(int) );
+  save_graph( g->garage_graph , fp );
+
+  for ( i = 0 ; i < g->E ; i++ ) {
+    write_model( fp , &(g->entries[i].index) , sizeof(int) );
+    save_tree( g->entries[i].t , fp );
+  }
+
+  for ( i = 0 ; i < 5 ; i++ ) {
+    write_model( fp , &(g->exits[i].n) , sizeof(int) );
+    write_model( fp , g->exits[i].data , g->exits[i].n * sizeof(int) );
+    for ( k = 0 ; k < g->exits[i].n ; k++ ) {
+      save_tree( g->exit_trees[i][k] , fp );
+    }
+  }
+
+  write_model( fp , &(g->n_parks) , sizeof(int) );
+  write_model( fp , g->park_cell , (g->n_parks + 1) * sizeof(int) );
+  write_model( fp , g->park_rank , g->N * g->M * g->P * sizeof(int) );
+
+  return close_model( fp , path );
+}
+
+/* Interface function: creates the garage from the model in the path given, if there is one
+   made from the configuration file with the key given (and with the graph asked). Its arrays
+   are used where they are mapped. Its trees are valid, but for the ones evicted to stay within
+   the memory budget given (0 for none), made again when needed. Returns NULL otherwise. */
+garage* map_garage( char *path , model_key key , int graph_type , int tree_type , long budget )
+{
+  model *m;
+  garage *g;
+  int *dims, *n, *cells, i, k, ok, size;
+
+  m = open_model( path , key );
+  if ( m == NULL )
+    return NULL;
+
+  dims = (int*) read_model( m , 8 * sizeof(int) );
+  if ( dims == NULL || (graph_type != GRAPH_AUTO && graph_type != dims[6]) ||
+       (tree_type != TREE_AUTO && tree_type != dims[7]) ) {
+    destroy_model( m );
+    return NULL;
+  }
+
+  g = (garage*) malloc( sizeof(garage) );
+  mem_check(g);
+
+  g->graph_type = dims[6];
+  g->tree_type = dims[7];
+  g->mapped = m;
+  g->N = dims[0];
+  g->M = dims[1];
+  g->P = dims[2];
+  g->E = dims[3];
+  g->A = dims[4];
+  size = g->N * g->M * g->P;
+
+  alloc_garage( g );
+  g->empty_parks = dims[5];
+
+  /* The budget holds while the trees are mapped: the pages of the ones evicted are given back. */
+  set_budget_lru( g->trees , budget );
+
+  g->info = (int*) read_model( m , size * sizeof(int) );
+  g->garage_graph = NULL;
+  ok = ( g->info != NULL );
+  ok = ok && ( (g->garage_graph = map_graph( m , g->N , g->M , g->P , g->info )) != NULL );
+
+  for ( i = 0 ; i < g->E && ok ; i++ ) {
+    ok = ( (n = (int*) read_model( m , sizeof(int) )) != NULL );
+    ok = ok && ( (g->entries[i].t = map_tree( m , g->N , g->M , g->P )) != NULL );
+    if ( ok ) {
+      g->entries[i].index = *n;
+      load_tree( g , i , &(g->entries[i].t) );
+    }
+    g->valid_entry[i] = 1;
+  }
+
+  for ( i = 0 ; i < 5 && ok ; i++ ) {
+    ok = ( (n = (int*) read_model( m , sizeof(int) )) != NULL );
+    ok = ok && ( (cells = (int*) read_model( m , *n * sizeof(int) )) != NULL );
+    g->valid_exit[i] = 1;
+    if ( !ok || *n == 0 )
+      continue;
+    for ( k = 0 ; k < *n ; k++ ) {
+      int_vec_push( &(g->exits[i]) , cells[k] );
+    }
+    g->exit_trees[i] = (tree**) calloc( *n , sizeof(tree*) );
+    mem_check(g->exit_trees[i]);
+    for ( k = 0 ; k < *n && ok ; k++ ) {
+      ok = ( (g->exit_trees[i][k] = map_tree( m , g->N , g->M , g->P )) != NULL );
+    }
+    if ( ok )
+      load_tree( g , g->E + i , g->exit_trees[i] );
+  }
+
+  ok = ok && ( (n = (int*) read_model( m , sizeof(int) )) != NULL );
+  if ( ok )
+    g->n_parks = *n;
+  ok = ok && ( (g->park_cell = (int*) read_model( m , (g->n_parks + 1) * sizeof(int) )) != NULL );
+  ok = ok && ( (g->park_rank = (int*) read_model( m , size * sizeof(int) )) != NULL );
+
+  /* A model with the right header can only be broken if it was changed by hand. */
+  if ( !ok ) {
+    fprintf(stderr, "Error reading model %s. \n", path);
+    exit(0);
+  }
+
+  alloc_park_index( g );
+  g->ws = new_workspace( g->garage_graph );
+
   return g;
 }
 
 /* Interface function: generate restrictions from its file. */
-void read_restrict( garage *g, FILE *fpr )
+void read_restrict( garage *g, scanner *in )
 {
-  g->r_data = init_restrict(fpr, g->M, g->N);
+  g->r_data = init_restrict(in, g->M, g->N, g->P);
 }
 
 /* Interface function: set no restriction. */
@@ -264,53 +525,71 @@ void no_restrict( garage *g)
 void update_spt_entries(garage* g, int i)
 {
 
-  generate_spt(g->garage_graph, g->info, g->M, g->N, g->entries[i].spt, g->entries[i].wt, g->entries[i].index);
+  update_tree(g->garage_graph, g->ws, g->info, g->M, g->N, g->entries[i].t, g->entries[i].index, NULL, 0);
   g->valid_entry[i] = 1;
+  invalidate_weights(g);
 }
 
+/* Makes the trees of the exits of type i, a search from each of them. */
 void update_spt_exits(garage* g, int i)
 {
+  int k;
 
-  access *e;
-  LinkedList *list1 = g->exits[i];
-
-  while(list1 != NULL) {
-    e = (access*) getItemLinkedList(list1);
-    generate_spt(g->garage_graph, g->info, g->M, g->N, e->spt, e->wt, e->index);
-
-    list1 = getNextNodeLinkedList(list1);
+  for ( k = 0 ; k < g->exits[i].n ; k++ ) {
+    update_tree(g->garage_graph, g->ws, g->info, g->M, g->N, g->exit_trees[i][k], g->exits[i].data[k], NULL, 0);
   }
   g->valid_exit[i] = 1;
+  invalidate_weights(g);
 
 }
 
+/* Puts the exits of each type with the last read first, the order that breaks the ties between
+   them, and makes room for their trees. */
+void order_exits( garage *g )
+{
+  int i, k, n, cell;
+
+  for ( i = 0 ; i < 5 ; i++ ) {
+    n = g->exits[i].n;
+    for ( k = 0 ; k < n / 2 ; k++ ) {
+      cell = g->exits[i].data[k];
+      g->exits[i].data[k] = g->exits[i].data[n - 1 - k];
+      g->exits[i].data[n - 1 - k] = cell;
+    }
+
+    if ( n > 0 ) {
+      g->exit_trees[i] = (tree**) calloc( n , sizeof(tree*) );
+      mem_check(g->exit_trees[i]);
+    }
+  }
+}
+
 
 /* Function responsible for choosing the right times to write in output: 
 these times are when the car changes direction, parks, reaches the exit, didn't change direction
 but made some move, on foot or by car . The direction changes are seen by the difference between 
 the present position and the position before and between the next position and the present position */ 
-void write_direction(garage *g, FILE* fp, car *c, LinkedList* path, int p, int te)
+void write_direction(garage *g, writer* out, car *c, int* path, int n, int p, int te)
 {
-  LinkedList *aux1, *aux2;
+  int *aux1;
   int *s2, *s3;
 	/* Flag responsible for the type of movement to write and for knowing if we have to write a movement when there aren't any direction changes*/
   int ap = 0;
 	int dif1 = 0, dif2 = 0, first, t_p = 0, t_e, t_a, t;
-  s2 = getItemLinkedList(path);
+  s2 = path;
 	/* Dertermining the time when the car appears on an entry */
   t_e = c->t;
 	/* Dertermining the time when the car starts to move */
   t = te;
-  aux1 = getNextNodeLinkedList(path);
+  aux1 = path + 1;
 
-	/* Run through the list of the position of the way until reach the position of the exit*/
-  while(getNextNodeLinkedList(aux1) != NULL) {
+	/* Run through the positions of the way until reach the position of the exit*/
+  while(aux1 + 1 < path + n) {
     t++;
 
     first = *s2;
-    s2 = getItemLinkedList(aux1);
-    aux2 = getNextNodeLinkedList(aux1);
-    s3 = getItemLinkedList(aux2);
+    s2 = aux1;
+    s3 = aux1 + 1;
     dif1 = *s3 - *s2;
     dif2 = *s2 - first;
 		/*When teh car goes up or down the time that the movement lasts is 2*/
@@ -321,87 +600,58 @@ void write_direction(garage *g, FILE* fp, car *c, LinkedList* path, int p, int t
       t_p = t;
 		
 			/*If the car never changes direction in the movement until reaching the park, write a 'm' movent on the position before*/
-			if(ap == 0) escreve_saida(fp, c->tag, t-1, get_x(first, g->N), get_y(first, g->M, g->N), get_z(first, g->N, g->M), 'm');
+			if(ap == 0) write_move(out, c->tag, t-1, get_x(first, g->N), get_y(first, g->M, g->N), get_z(first, g->N, g->M), 'm');
 			
 			/* Change of the flag value in order to start writing on foot movements */      
 			ap = 1;
-      escreve_saida(fp, c->tag, t, get_x(*s2, g->N), get_y(*s2, g->M, g->N), get_z(*s2, g->N, g->M), 'e');
+      write_move(out, c->tag, t, get_x(*s2, g->N), get_y(*s2, g->M, g->N), get_z(*s2, g->N, g->M), 'e');
     }else if(dif1 != dif2 && ap <= 0){
-      escreve_saida(fp, c->tag, t, get_x(*s2, g->N), get_y(*s2, g->M, g->N), get_z(*s2, g->N, g->M), 'm');
+      write_move(out, c->tag, t, get_x(*s2, g->N), get_y(*s2, g->M, g->N), get_z(*s2, g->N, g->M), 'm');
 			ap--;
     }else if(ap > 0 && dif1 != dif2){
-        escreve_saida(fp, c->tag, t, get_x(*s2, g->N),get_y(*s2, g->M, g->N), get_z(*s2, g->N, g->M), 'p');
+        write_move(out, c->tag, t, get_x(*s2, g->N),get_y(*s2, g->M, g->N), get_z(*s2, g->N, g->M), 'p');
 				ap++;
     }
 
-    aux1 = getNextNodeLinkedList(aux1);
+    aux1++;
   }
 
 	/*If the car never changes direction in the movement until reaching the exit, write a 'p' movent on the position before*/
 	if( ap == 1 )
 	{
-		escreve_saida(fp, c->tag, t, get_x(*s2, g->N),get_y(*s2, g->M, g->N), get_z(*s2, g->N, g->M), 'p');
+		write_move(out, c->tag, t, get_x(*s2, g->N),get_y(*s2, g->M, g->N), get_z(*s2, g->N, g->M), 'p');
 	}
 
-  s2 = getItemLinkedList(aux1);
+  s2 = aux1;
   t++;
 	/* Dertermining the time when the person reaches the exit */
   t_a = t;
 	
-  escreve_saida(fp, c->tag, t, get_x(*s2, g->N), get_y(*s2, g->M, g->N), get_z(*s2, g->N, g->M), 'a');
-
-  escreve_saida(fp, c->tag, t_e, t_p, t_a, (t_p - t_e) + COST_MULT*(t_a - t_p), 'x');
+  write_move(out, c->tag, t, get_x(*s2, g->N), get_y(*s2, g->M, g->N), get_z(*s2, g->N, g->M), 'a');
 
-  freeLinkedList(path, free);
+  write_move(out, c->tag, t_e, t_p, t_a, (t_p - t_e) + COST_MULT*(t_a - t_p), 'x');
 
 }
 
 /* Function responsible for parking a car, updating the spt's and wt's when needed */
-int park_car(car* c, garage * g, FILE* fp, int t_e)
+int park_car(car* c, garage * g, writer* out, int t_e)
 {
-  int ie = 0, i, min_v = -1, min_dist = 0, result;
-  int *p;
-  LinkedList *list_p, *list_a, *path;
-  access *min_exit, *a;
+  int ie = 0, min_v, n, k;
   p_car *pc;
 
   while( g->entries[ie].index != c->index_entry ){
     ie++;
   }
-  /* If the entries and exits spts and wts are invalid at the time update them*/
-  if( g->valid_entry[ie] != 1 )
-    update_spt_entries(g, ie);
-
-  if( g->valid_exit[c->exit_code] != 1 )
-    update_spt_exits(g, c->exit_code);
-
-  /* Determine the way with the minimum cost */ 
-  for( i = 0; i < g->P; i++){
-    if(g->valid_floors[i] == 0){
-      list_p = g->park_spaces[i];
-      while( list_p != NULL){
-	p = getItemLinkedList(list_p);
-	if(g->info[*p] == PARK_PLACE_E && g->entries[ie].wt[*p] != -1){
-	  list_a = g->exits[c->exit_code];
-	  while(list_a != NULL){
-	    a = getItemLinkedList(list_a);
-	    if(a->wt[*p] != -1){
-	      result = g->entries[ie].wt[*p] + COST_MULT * a->wt[*p];
-	      if(min_v == -1 || result < min_dist){
-
-		min_v = *p;
-		min_exit = a;
-		min_dist = result;
-
-	      }
-	    }
-	    list_a = getNextNodeLinkedList(list_a);
-	  }
-	}
-	list_p = getNextNodeLinkedList(list_p);
-      }
-    }
-  }
+  /* No exit of that type, the car has nowhere to go (and the type has no tree). */
+  if( g->exits[c->exit_code].n == 0 )
+    return 0;
+
+  /* Bring the trees of the entry and the exits to the cache, and make them if invalid. */
+  use_tree(g, ie);
+  use_tree(g, g->E + c->exit_code);
+
+  /* Determine the way with the minimum cost */
+  min_v = best_park(g, ie, c->exit_code);
 
   /* Check if car parking failed (maybe due to restrictions). */
   if (min_v == -1) return 0;
@@ -411,209 +661,114 @@ int park_car(car* c, garage * g, FILE* fp, int t_e)
 
 	/*Occupy the park chosen*/
   change_id( g->info[min_v], PARK_PLACE_O );
+  occupy_park( g , min_v );
 
-  pc = (p_car*) malloc(sizeof(p_car));
-  pc->tag = (char*) malloc((strlen(c->tag) + 2)*sizeof(char));
-  strcpy(pc->tag,c->tag);
-  pc->index_park = min_v;
+  pc = new_p_car(g, c->tag, min_v);
 
-  put_h_table(g->parked_cars, pc, pc->tag);
+  car_map_put(&(g->parked_cars), pc->tag, pc);
 
-  path = get_path( min_v , g->entries[ie].spt, min_exit->spt );
+  /* The way goes to the exit nearest to the park, and is written to the garage buffer,
+     used again by every car. */
+  exit_weight( g , c->exit_code , min_v , &k );
+  n = get_path( min_v , g->entries[ie].t, g->exit_trees[c->exit_code][k] , &(g->path) , &(g->max_path) );
 
-  write_direction(g, fp, c, path, min_v, t_e);
+  write_direction(g, out, c, g->path, n, min_v, t_e);
 
   return 1;
 
 }
 
-/******************************************************************************
- * escreve_saida ()
- *
- * Arguments: fp - descriptor do ficheiro de saida
- *            vid - identificador da viatura
- *            tk - instante de tempo em que ocorre o movimento
- *            pX, pY, pZ - coordenadas (X,Y,Z) da viatura em movimento
- *            tm - tipo de movimento
- * Returns: 0 - se nao houver qualquer erro, ou seja se as coordenadas
- *              corresponderem a uma posicao valida
- *          -1 - se houver algum erro
- * Side-Effects: nenhum
- *
- * Description: escreve no ficheiro de saida um tuplo de valores do tipo
- *                          Vid T X Y Z M
- *              sendo Vid o identificador da viatura, T o instante de tempo,
- *              X, Y e Z  indicam a posicao da viatura no parque de
- *              estacionamento e M e' o tipo de movimento podendo apenas ter
- *              os caracteres 'i', 'm', 'e', 'p', 'a', 'x' ou 's'.
- *
- *****************************************************************************/
-
-int escreve_saida(FILE *fp, char *vid, int tk, int pX, int pY, int pZ, char tm)
-{
-  static char pvid[MAX_ID_SIZE];
-  static int ptk = -1, ppx, ppy, ppz;
-
-  int retval = 0;    /* valor retornado quando não há erro;
-                      * se houver erro retval = -1
-                      */
-  char *bogus = "??";
-
-  if(fp == NULL) {
-    fprintf(stderr, "Ficheiro invalido.\n");
-    exit(1);
-  }
-
-  /* check for valid range of values and valid type of move */
-  if (vid == NULL) {
-    vid = bogus;
-    fprintf(stderr, "Argumentos invalidos: Identificador de viatura nulo!\n");
-    fprintf(stderr, "Chamada erronea:\t\t\t%s %d %d %d %d %c\n",
-            vid, tk, pX, pY, pZ, tm);
-    retval = -1;
-  } else if (tk < 0) {
-    fprintf(stderr, "Argumentos invalidos: tempo negativo!\n");
-    fprintf(stderr, "Chamada erronea:\t\t\t%s %d %d %d %d %c\n",
-            vid, tk, pX, pY, pZ, tm);
-    retval = -1;
-  } else if (pX <0 || pY <0 || pZ <0) {
-    fprintf(stderr, "Argumentos invalidos: coordenadas erradas!\n");
-    fprintf(stderr, "Chamada erronea:\t\t\t%s %d %d %d %d %c\n",
-            vid, tk, pX, pY, pZ, tm);
-    retval = -1;
-  } else if (tm != 'i' && tm != 'x' && tm != 'e' && tm != 'm' && tm != 'p'
-             && tm != 's' && tm != 'a') {
-    fprintf(stderr, "Argumentos invalidos: tipo de movimento!\n");
-    fprintf(stderr, "Chamada erronea:\t\t\t%s %d %d %d %d %c\n",
-            vid, tk, pX, pY, pZ, tm);
-    retval = -1;
-  } else {
-    if (ptk != -1) { /* 2nd execution */
-      /* Note: this is abusive; this assumes that identifiers for different
-       * are in different memory locations.
-       * If this is not the case, comment out this test!
-       */
-      if (!strcmp(vid, pvid)) {
-        /* same vehicle as in last call; exclude summary and exit lines */
-        if ((tm == 'i') || (tm == 'm') || (tm == 'e') ||
-            (tm == 'p') || (tm == 'a')) {
-          if (tk <= ptk) {
-            /* invalid tk */
-            fprintf(stderr, "tk deve ser maior que %d.\n", ptk);
-            fprintf(stderr, "Chamada erronea:\t\t\t%s %d %d %d %d %c\n",
-                    vid, tk, pX, pY, pZ, tm);
-            retval = -1;
-          } else  if (pZ == ppz && pX == ppx && pY == ppy) {
-            /* it did not move at all */
-            fprintf(stderr, "Viatura %s não se moveu.\n", vid);
-            fprintf(stderr, "Chamada erronea:\t\t\t%s %d %d %d %d %c\n",
-                    vid, tk, pX, pY, pZ, tm);
-            retval = -1;
-          } else if (pZ == ppz && pX != ppx && pY != ppy) {
-              /* diagonal move on same floor*/
-              fprintf(stderr, "Movimento invalido: ");
-              fprintf(stderr,
-                      "linha e coluna nao podem mudar em simultaneo.\n");
-              fprintf(stderr, "Chamada erronea:\t\t\t%s %d %d %d %d %c\n",
-                      vid, tk, pX, pY, pZ, tm);
-              retval = -1;
-            } else if (pZ != ppz && (pX != ppx || pY != ppy)) {
-              /* level changes with some lateral move*/
-              fprintf(stderr, "Movimento invalido: ");
-              fprintf(stderr,
-                      "linha e coluna devem ser iguais ao nivel anterior.\n");
-              fprintf(stderr, "Chamada erronea:\t\t\t%s %d %d %d %d %c\n",
-                      vid, tk, pX, pY, pZ, tm);
-              retval = -1;
-            }
-        }
-      }
-    }
-  }
-  if (retval == 0) {
-    /* keep info from this run through */
-    strncpy(pvid, vid, MAX_ID_SIZE);
-    ptk = tk;
-    ppx = pX; ppy = pY; ppz = pZ;
-
-    /* generate output */
-    fprintf(fp, "%s %d %d %d %d %c\n", vid, tk, pX, pY, pZ, tm);
-  }
-
-  return(retval);
-}
-
 /* Interface function: */
-/* Fuction responsible for proccessing the entire car file: park, remove, insert in the queue */
-void process_car_file( garage *g , FILE *car_in , FILE *car_out )
+/* Fuction responsible for proccessing the entire car file: park, remove, insert in the queue.
+   Returns -1 if the moves could not be written (the cars left are not handled), 0 otherwise. */
+int process_car_file( garage *g , events *car_in , writer *out )
 {
   queue *car_queue;
-  char buffer[LINE_SIZE], tag[LINE_SIZE], *taux;
-  int t = -1, t_new, res, size = g->M * g->P * g->N, x, y, z, ver;
-  char type;
+  wait_map waiting_cars;
+  car *waiting;
+  car_event e;
+  char *tag;
+  int t = -1, res, size = g->M * g->P * g->N, *xyz = e.pos, failed = 0;
+  int *changed, n_changed;
 
   /* Hash table for car id -> car place convertion. */
-  g->parked_cars = new_h_table(H_TABLE_SIZE, car_function, compare_car, destroy_p_car);
+  car_map_init(&(g->parked_cars), H_TABLE_SIZE);
 
-  /* Queue of cars waiting for a park place. */
+  /* Cars read from a stream need their own tags, as the lines do not last. */
+  g->own_tags = !tags_last(car_in);
+
+  /* Queue of cars waiting for a park place, and the first of them with each tag, as they
+     may leave while waiting. */
   car_queue = new_queue();
+  wait_map_init(&waiting_cars, 16);
+
+  /* With no memory budget, all the trees are made at once, before they are needed.
+     Otherwise, each one is made when first needed. */
+  if ( budget_lru(g->trees) == 0 )
+    load_all_trees(g);
+  update_all_trees(g);
 
-  while ( fgets( buffer , LINE_SIZE , car_in ) != NULL ) {
-    /* Check if the line read has valid info. If it hasn't ignore it. */
-    if ( sscanf( buffer , "%*s %d" , &t_new) != 1 ) continue;
+  /* Only the events with a tag and an instant are given. The type and the position of the
+     last event stay in e when the next one has none. */
+  while ( next_event( car_in , &e ) ) {
+    tag = e.tag;
 
     /* Processes restrictions, if they exist (r_data != NULL). */
-    if ( g->r_data != NULL && t < t_new ) {
+    if ( g->r_data != NULL && t < e.t ) {
       /* Check if there were any changes until the new instant. */
-      res = update_restrict( g->r_data , &t , t_new );
+      res = update_restrict( g->r_data , &t , e.t );
 
       if ( res != 0 ) {
+	/* Parks may have become usable or not. */
+	invalidate_index(g);
+
 	if ( res == 1 ) {
 	  /* Only floor restrictions changed. */
 	  apply_restrict_parcial(g->r_data, g->valid_floors, g->P);
 	} else {
-	  /* Pos, and maybe floor, restrictions changed. */
-	  apply_restrict_complete(g->r_data, g->info, size, g->valid_floors, g->P);
-	  mark_invalid(g);
+	  /* Pos, and maybe floor, restrictions changed. The trees already made are repaired. */
+	  changed = apply_restrict_complete(g->r_data, g->info, size, g->valid_floors, g->P, &n_changed);
+	  repair_trees(g, changed, n_changed);
 	}
       }
     }
     
-    t = t_new;
+    t = e.t;
 
-    /* Process the line read. */
-    ver = sscanf( buffer , "%s %*d %c %d %d %d" , tag, &type, &x, &y, &z );
-    if(type != 'S') {
+    if(e.type != 'S') {
       /* A car entered the garage. */
       
-      car *c = (car*) malloc(sizeof(car));
-      c->tag = (char*) malloc((strlen(tag)+2) * sizeof(char));
+      car *c = new_car(g, tag);
       c->t = t;
-      c->index_entry = get_index(x, y, z, g->M, g->N);
-      c->exit_code = convert_type(type);
-      strcpy(c->tag, tag);
-      escreve_saida(car_out, c->tag, c->t, get_x(c->index_entry, g->N), get_y(c->index_entry, g->M, g->N), get_z(c->index_entry, g->N, g->M), 'i');
+      c->index_entry = get_index(xyz[0], xyz[1], xyz[2], g->M, g->N);
+      c->exit_code = convert_type(e.type);
+      write_move(out, c->tag, c->t, get_x(c->index_entry, g->N), get_y(c->index_entry, g->M, g->N), get_z(c->index_entry, g->N, g->M), 'i');
       
-      if ( g->empty_parks > 0 && park_car(c, g, car_out, c->t) == 1 ) {
+      if ( g->empty_parks > 0 && park_car(c, g, out, c->t) == 1 ) {
 	/* Car can be parked and the parking was successful. */
-	destroy_car(c);
+	destroy_car(g, c);
       } else {
-	insert_queue( car_queue , c);
+	wait_car( &waiting_cars , car_queue , c );
       }
 
     } else {
       /* A car exited the garage. */
-      
-      taux = (char*) malloc((strlen(tag) + 2) * sizeof(char));
-      strcpy(taux, tag);
-      if(ver > 3) {
-	change_id( g->info[get_index(x, y, z, g->M, g->N)], PARK_PLACE_E);
-	escreve_saida(car_out, taux, t, x, y, z, 's');
+
+      /* A car still waiting just leaves the queue, and no park is emptied. */
+      if ( e.fields <= 3 && (waiting = leave_queue( &waiting_cars , car_queue , tag )) != NULL ) {
+	destroy_car( g , waiting );
+	continue;
+      }
+
+      if(e.fields > 3) {
+	change_id( g->info[get_index(xyz[0], xyz[1], xyz[2], g->M, g->N)], PARK_PLACE_E);
+	free_park( g , get_index(xyz[0], xyz[1], xyz[2], g->M, g->N) );
+	write_move(out, tag, t, xyz[0], xyz[1], xyz[2], 's');
 	
-      }else{
-	remove_car(g, taux, car_out, t);
+      }else if ( remove_car(g, tag, out, t) == 0 ) {
+	/* Unknown car, no park was emptied. */
+	continue;
       }
-      free(taux);
 
       g->empty_parks++;
 
@@ -621,117 +776,613 @@ void process_car_file( garage *g , FILE *car_in , FILE *car_out )
       if ( g->empty_parks > 0 && !isEmpty_queue(car_queue) ){
 	car *ent_c = peek_queue(car_queue);
 	
-	if ( park_car(ent_c, g, car_out, t) == 1 ) {
-	  destroy_car(ent_c);
-	  remove_queue(car_queue);
+	if ( park_car(ent_c, g, out, t) == 1 ) {
+	  /* The first car in the queue is the first waiting with its tag. */
+	  leave_queue( &waiting_cars , car_queue , ent_c->tag );
+	  destroy_car(g, ent_c);
 	  ent_c = NULL;
 	}
       }
     }
+
+    /* The moves of the car handled are written now, if the output is a stream. */
+    if ( end_event(out) != 0 ) {
+      failed = 1;
+      break;
+    }
   }
 
   /* Libertação da fila, inclusive dos carros que não conseguiram ser estacionados. */
-  destroy_queue( car_queue , destroy_car );
+  while ( !isEmpty_queue(car_queue) ) {
+    destroy_car( g , (car*) remove_queue(car_queue) );
+  }
+  destroy_queue( car_queue , NULL );
+  wait_map_free(&waiting_cars);
+
+  return failed ? -1 : 0;
 }
 
-void remove_car( garage* g , char* tag , FILE* fp , int t )
+/* Puts a car at the end of the queue, and after the cars waiting with its tag. */
+void wait_car( wait_map *m , queue *q , car *c )
+{
+  car **first, *last;
+
+  c->entry = insert_queue( q , c );
+  c->same_tag = NULL;
+
+  if ( (first = wait_map_get( m , c->tag )) == NULL ) {
+    wait_map_put( m , c->tag , c );
+    return;
+  }
+  for ( last = *first ; last->same_tag != NULL ; last = last->same_tag );
+  last->same_tag = c;
+}
+
+/* Takes the first car waiting with the tag given out of the queue, by its entry, and returns
+   it (NULL if none is waiting). */
+car* leave_queue( wait_map *m , queue *q , char *tag )
+{
+  car *c;
+
+  if ( wait_map_remove( m , tag , &c ) == 0 )
+    return NULL;
+  if ( c->same_tag != NULL )
+    wait_map_put( m , c->same_tag->tag , c->same_tag );
+
+  remove_entry_queue( q , c->entry );
+
+  return c;
+}
+
+/* Removes a parked car, returning 0 if there is none with the tag given. */
+int remove_car( garage* g , char* tag , writer* out , int t )
 {
     p_car* cl;
 
-    cl = remove_h_table(g->parked_cars, tag);
+    if ( car_map_remove(&(g->parked_cars), tag, &cl) == 0 )
+      return 0;
     change_id( g->info[cl->index_park], PARK_PLACE_E );
+    free_park( g , cl->index_park );
 
-    escreve_saida(fp, cl->tag, t, get_x(cl->index_park, g->N), get_y(cl->index_park, g->M, g->N), get_z(cl->index_park, g->M, g->N), 's');
-    destroy_p_car(cl);
+    write_move(out, cl->tag, t, get_x(cl->index_park, g->N), get_y(cl->index_park, g->M, g->N), get_z(cl->index_park, g->M, g->N), 's');
+    destroy_p_car(g, cl);
+    return 1;
 }
 
-void mark_invalid( garage *g )
+/* Repairs the valid trees, after the positions whose restriction changed (n of them). */
+void repair_trees( garage *g , int *changed , int n )
 {
-  int i;
-  for(i = 0; i < 5; i++) {
-    g->valid_exit[i] = 0;
+  int size = g->N * g->M * g->P;
+
+  if ( n == 0 )
+    return;
+
+  /* Too many changes, it is faster to make the trees again. */
+  if ( n > size / REPAIR_LIMIT ) {
+    mark_invalid(g);
+    update_all_trees(g);
+    return;
   }
-  for(i = 0; i < g->E; i++) {
-    g->valid_entry[i] = 0;
+
+  run_trees( g , 1 , changed , n );
+}
+
+/* Makes all the invalid trees at once, by the workers. */
+void update_all_trees( garage *g )
+{
+  run_trees( g , 0 , NULL , 0 );
+}
+
+/* Returns where the tree of entry col, or the trees of the exits of type col-E, are kept. */
+tree** tree_slot( garage *g , int col )
+{
+  return col < g->E ? &(g->entries[col].t) : g->exit_trees[col - g->E];
+}
+
+/* Returns the number of trees of entry col (one), or of the exits of type col-E. */
+int n_trees( garage *g , int col )
+{
+  return col < g->E ? 1 : g->exits[col - g->E].n;
+}
+
+/* Puts the trees of entry col (or exit type col-E) in the cache, evicting the least recently
+   used ones until they fit in the budget. New (invalid) trees are made if t is NULL. */
+void load_tree( garage *g , int col , tree **t )
+{
+  tree **slot = tree_slot( g , col );
+  long size = n_trees( g , col ) * bytes_tree( g->N , g->M , g->P , tree_kind(g) == TREE_PACKED );
+  int victim, k;
+
+  while ( (victim = victim_lru( g->trees , size )) != -1 ) {
+    drop_tree( g , victim );
+  }
+
+  for ( k = 0 ; k < n_trees( g , col ) ; k++ ) {
+    slot[k] = t != NULL ? t[k] : new_tree( g->N , g->M , g->P , tree_kind(g) == TREE_PACKED );
   }
+  insert_lru( g->trees , col , size );
 }
 
-/* Hash function sorting the cars based on the fisrt three characters (excepting V) of the name of the car*/
-int car_function( Item c1 , int size )
+/* Frees the trees of entry col (or exit type col-E), which are made again when needed. */
+void drop_tree( garage *g , int col )
 {
-  int result;
-  char* c;
-  c = (char*) c1;
-  if(strlen(c) >= 4){
-    result = (c[1]*(32)^2) + (c[2]*(32)^1) + (c[3]*(32)^0);
-  }else if(strlen(c) == 3){
-    result = (c[1]*(32)^2) + (c[2]*(32)^1) + (' '*(32)^0);
-  }else{
-    result = (c[1]*(32)^2) + (' '*(32)^1) + (' '*(32)^0);
+  tree **t = tree_slot( g , col );
+  int k;
+
+  remove_lru( g->trees , col );
+  for ( k = 0 ; k < n_trees( g , col ) ; k++ ) {
+    destroy_tree( t[k] );
+    t[k] = NULL;
   }
 
-  return result %  size;
+  if ( col < g->E )
+    g->valid_entry[col] = 0;
+  else
+    g->valid_exit[col - g->E] = 0;
+}
+
+/* The trees of entry col (or exit type col-E) are needed: they are brought to the cache and
+   made, if they are not there or are invalid. */
+void use_tree( garage *g , int col )
+{
+  if ( !use_lru( g->trees , col ) )
+    load_tree( g , col , NULL );
+
+  if ( col < g->E ) {
+    if ( g->valid_entry[col] != 1 )
+      update_spt_entries( g , col );
+  } else {
+    if ( g->valid_exit[col - g->E] != 1 )
+      update_spt_exits( g , col - g->E );
+  }
+}
+
+/* Puts in the cache all the trees not there (ignoring the budget), to be made at once. */
+void load_all_trees( garage *g )
+{
+  int i;
+
+  for ( i = 0 ; i < g->E + 5 ; i++ ) {
+    if ( n_trees( g , i ) > 0 && tree_slot( g , i )[0] == NULL )
+      load_tree( g , i , NULL );
+  }
+}
+
+/* Interface function: sets the memory budget of the trees, in bytes (0 for none). The trees
+   are then only made when needed, and the least recently used are freed to stay within it. */
+void set_tree_budget( garage *g , long budget )
+{
+  set_budget_lru( g->trees , budget );
+}
+
+/* Interface function: gives the number of times a tree was needed and was in memory (hits),
+   was not (misses), and of trees freed to stay within the budget (evictions). */
+void tree_stats( garage *g , long *hits , long *misses , long *evictions )
+{
+  stats_lru( g->trees , hits , misses , evictions );
 }
 
-int compare_car(Item c1, Item c2)
+/* Interface function: gives the dimensions of the garage: N by M, on P floors. */
+void size_garage( garage *g , int *N , int *M , int *P )
 {
-  if(strcmp((char*) c1, (char*) c2) == 0) return 1;
+  *N = g->N;
+  *M = g->M;
+  *P = g->P;
+}
+
+/* Private. Gives the workers a job per tree whose valid mark is the one given: trees are
+   made if changed is NULL, and repaired otherwise (only the ones the changes touch). All of them
+   are valid at the end. */
+void run_trees( garage *g , int valid , int *changed , int n_changed )
+{
+  spt_job *jobs;
+  int i, k, n = g->E;
+
+  for ( i = 0 ; i < 5 ; i++ ) {
+    n += g->exits[i].n;
+  }
+  jobs = (spt_job*) malloc( n * sizeof(spt_job) );
+  mem_check(jobs);
+  n = 0;
+
+  for ( i = 0 ; i < g->E ; i++ ) {
+    if ( (g->valid_entry[i] == 1) != valid || g->entries[i].t == NULL )
+      continue;
+    if ( changed != NULL && !tree_touched( g , g->entries[i].t , g->entries[i].index , changed , n_changed ) )
+      continue;
+
+    jobs[n].t = g->entries[i].t;
+    jobs[n].source = g->entries[i].index;
+    n++;
+    g->valid_entry[i] = 1;
+  }
+
+  for ( i = 0 ; i < 5 ; i++ ) {
+    if ( (g->valid_exit[i] == 1) != valid || g->exits[i].n == 0 || g->exit_trees[i][0] == NULL )
+      continue;
+
+    for ( k = 0 ; k < g->exits[i].n ; k++ ) {
+      if ( changed != NULL && !tree_touched( g , g->exit_trees[i][k] , g->exits[i].data[k] , changed , n_changed ) )
+	continue;
+
+      jobs[n].t = g->exit_trees[i][k];
+      jobs[n].source = g->exits[i].data[k];
+      n++;
+    }
+    g->valid_exit[i] = 1;
+  }
+
+  run_spt_jobs( g->garage_graph , g->ws , g->info , g->M , g->N , jobs , n , changed , n_changed );
+  invalidate_weights(g);
+
+  free(jobs);
+}
+
+/* Private. Checks if the changes can change a tree (grown from the source given): a position
+   blocked that it reached, or one opened that it found blocked or that is its source.
+   Any other position is not next to an explored one, so the searches never get to it. */
+int tree_touched( garage *g , tree *t , int source , int *changed , int n_changed )
+{
+  int i, p, v;
+
+  for ( i = 0 ; i < n_changed ; i++ ) {
+    v = changed[i];
+    p = parent_tree( t , v );
+
+    if ( get_flag(g->info[v]) != 0 ) {
+      if ( p >= 0 )
+	return 1;
+    } else {
+      if ( p == -2 || v == source )
+	return 1;
+    }
+  }
+
   return 0;
 }
 
+/* Numbers the parks in the order they were scanned (by floor, and then the last read first),
+   which breaks the ties between parks with the same cost. The park indexes are made when needed. */
+void make_park_ranks( garage *g )
+{
+  int i, k, size = g->N * g->M * g->P;
+
+  g->n_parks = 0;
+  for ( i = 0 ; i < g->P ; i++ ) {
+    g->n_parks += g->park_spaces[i].n;
+  }
+
+  g->park_cell = (int*) malloc( (g->n_parks + 1) * sizeof(int) );
+  g->park_rank = (int*) malloc( size * sizeof(int) );
+  mem_check(g->park_cell);
+  mem_check(g->park_rank);
+
+  for ( i = 0 ; i < size ; i++ ) {
+    g->park_rank[i] = -1;
+  }
+
+  g->n_parks = 0;
+  for ( i = 0 ; i < g->P ; i++ ) {
+    for ( k = g->park_spaces[i].n - 1 ; k >= 0 ; k-- ) {
+      g->park_cell[g->n_parks] = g->park_spaces[i].data[k];
+      g->park_rank[g->park_cell[g->n_parks]] = g->n_parks;
+      g->n_parks++;
+    }
+
+    /* The lists were only kept to rank the parks. */
+    int_vec_free( &(g->park_spaces[i]) );
+  }
+
+  alloc_park_index( g );
+}
+
+/* Allocates the park indexes and the park weights, all invalid, for the parks ranked. */
+void alloc_park_index( garage *g )
+{
+  g->park_keys = (int*) malloc( (g->n_parks + 1) * sizeof(int) );
+  g->park_index = (i_heap**) calloc( g->E * 5 , sizeof(i_heap*) );
+  g->valid_index = (char*) calloc( g->E * 5 + 1 , sizeof(char) );
+  g->park_wt = (int*) malloc( ((g->E + 5) * g->n_parks + 1) * sizeof(int) );
+  g->valid_wt = (char*) calloc( g->E + 5 , sizeof(char) );
+  g->park_ok = (int*) malloc( (g->n_parks + 1) * sizeof(int) );
+  g->valid_ok = 0;
+  mem_check(g->park_keys);
+  mem_check(g->park_index);
+  mem_check(g->valid_index);
+  mem_check(g->park_wt);
+  mem_check(g->valid_wt);
+  mem_check(g->park_ok);
+}
+
+/* Returns the index of the free parks for cars from entry ie to exits of the type given, ordered
+   by cost (and rank). It is made again if the trees or restrictions changed since it was made. */
+i_heap* get_park_index( garage *g , int ie , int type )
+{
+  int k = ie * 5 + type;
+
+  if ( g->park_index[k] == NULL )
+    g->park_index[k] = new_i_heap( g->n_parks );
+
+  if ( g->valid_index[k] != 1 ) {
+    costs_park( g->n_parks , park_weights( g , ie ) , park_weights( g , g->E + type ) ,
+		park_mask( g ) , g->park_keys );
+    build_i_heap( g->park_index[k] , g->park_keys );
+    g->valid_index[k] = 1;
+  }
+
+  return g->park_index[k];
+}
+
+/* Returns the free park with the minimum cost for cars from entry ie to exits of the type given
+   (-1 if there is none). The first time after the index became invalid, the parks are only
+   scanned: if the index is made for a single car, it costs more than it saves. */
+int best_park( garage *g , int ie , int type )
+{
+  int k = ie * 5 + type, r;
+
+  if ( g->valid_index[k] == 0 ) {
+    g->valid_index[k] = 2;
+    r = argmin_park( g->n_parks , park_weights( g , ie ) , park_weights( g , g->E + type ) ,
+		     park_mask( g ) );
+  } else {
+    r = min_i_heap( get_park_index( g , ie , type ) );
+  }
+
+  return r == -1 ? -1 : g->park_cell[r];
+}
+
+/* Returns the weights of the parks (by rank) in the tree of entry col, or to the nearest exit of
+   type col-E, copying them from the trees if they changed. The trees must be valid. */
+int* park_weights( garage *g , int col )
+{
+  int *col_wt = g->park_wt + col * g->n_parks, r, k;
+
+  if ( g->valid_wt[col] == 0 ) {
+    for ( r = 0 ; r < g->n_parks ; r++ ) {
+      if ( col < g->E )
+	col_wt[r] = weight_tree( g->entries[col].t , g->park_cell[r] );
+      else
+	col_wt[r] = exit_weight( g , col - g->E , g->park_cell[r] , &k );
+    }
+    g->valid_wt[col] = 1;
+  }
+
+  return col_wt;
+}
+
+/* Returns the mask of the parks (by rank) that can be used: -1 if they are free, not restricted
+   and in a floor that is not restricted, 0 otherwise. */
+int* park_mask( garage *g )
+{
+  int r;
+
+  if ( g->valid_ok == 0 ) {
+    for ( r = 0 ; r < g->n_parks ; r++ ) {
+      g->park_ok[r] = park_usable( g , g->park_cell[r] ) ? -1 : 0;
+    }
+    g->valid_ok = 1;
+  }
+
+  return g->park_ok;
+}
+
+/* Returns the cost of parking in cell, from entry ie to an exit of the type given,
+   or -1 if the park can not be used. The trees must be valid. */
+int park_cost( garage *g , int ie , int type , int cell )
+{
+  int k, wt_e = weight_tree( g->entries[ie].t , cell ), wt_a = exit_weight( g , type , cell , &k );
+
+  if ( !park_usable( g , cell ) || wt_e == -1 || wt_a == -1 )
+    return -1;
+
+  return wt_e + COST_MULT * wt_a;
+}
+
+/* Returns the weight of cell from the nearest exit of the type given (-1 if none reaches it),
+   putting in k the first of them (as they are kept) with that weight. The trees must be valid. */
+int exit_weight( garage *g , int type , int cell , int *k )
+{
+  int i, w, best = -1;
+
+  *k = -1;
+  for ( i = 0 ; i < g->exits[type].n ; i++ ) {
+    w = weight_tree( g->exit_trees[type][i] , cell );
+    if ( w != -1 && (best == -1 || w < best) ) {
+      best = w;
+      *k = i;
+    }
+  }
+
+  return best;
+}
+
+/* Checks if the park in cell is free, not restricted and in a floor that is not restricted. */
+int park_usable( garage *g , int cell )
+{
+  return g->valid_floors[cell / (g->N * g->M)] == 0 && get_flag(g->info[cell]) == 0 &&
+    get_id(g->info[cell]) == PARK_PLACE_E;
+}
+
+/* The park indexes and mask must be made again. */
+void invalidate_index( garage *g )
+{
+  memset( g->valid_index , 0 , g->E * 5 );
+  g->valid_ok = 0;
+}
+
+/* The trees changed: the park weights must be copied again, and the indexes made again. */
+void invalidate_weights( garage *g )
+{
+  memset( g->valid_wt , 0 , g->E + 5 );
+  invalidate_index( g );
+}
+
+/* Takes an occupied park out of the indexes. */
+void occupy_park( garage *g , int cell )
+{
+  int k, r = g->park_rank[cell];
+
+  if ( r == -1 )
+    return;
+
+  g->park_ok[r] = 0;
+  for ( k = 0 ; k < g->E * 5 ; k++ ) {
+    if ( g->valid_index[k] == 1 )
+      remove_i_heap( g->park_index[k] , r );
+  }
+}
+
+/* Puts a freed park back in the indexes, where it can be used. */
+void free_park( garage *g , int cell )
+{
+  int k, r = g->park_rank[cell], cost;
+
+  if ( r == -1 )
+    return;
+
+  g->park_ok[r] = park_usable( g , cell ) ? -1 : 0;
+  for ( k = 0 ; k < g->E * 5 ; k++ ) {
+    if ( g->valid_index[k] == 1 ) {
+      cost = park_cost( g , k / 5 , k % 5 , cell );
+      if ( cost != -1 )
+	insert_i_heap( g->park_index[k] , r , cost );
+    }
+  }
+}
+
+void mark_invalid( garage *g )
+{
+  int i;
+  for(i = 0; i < 5; i++) {
+    g->valid_exit[i] = 0;
+  }
+  for(i = 0; i < g->E; i++) {
+    g->valid_entry[i] = 0;
+  }
+}
+
+/* Hash function of the car tags: FNV-1a over the whole tag, 32 bits. */
+unsigned long car_function( Item c1 )
+{
+  return fnv1a( c1 , strlen((char*) c1) , FNV_OFFSET );
+}
+
 /* Interface fuction: frees all resources used by the garage. */
 void destroy_garage( garage * g )
 {
-  int i;
+  int i, k;
 
+  destroy_workspace(g->ws);
   destroy_graph(g->garage_graph);
 
   for(i=0; i<g->E; i++){
     free(g->entries[i].name);
-    free(g->entries[i].wt);
-    free(g->entries[i].spt);
+    if (g->entries[i].t != NULL)
+      destroy_tree(g->entries[i].t);
   }
   free(g->entries);
 
   for(i = 0; i < 5; i++){
-    freeLinkedList(g->exits[i], destroy_access);
+    for(k = 0; k < g->exits[i].n; k++){
+      if (g->exit_trees[i][k] != NULL)
+	destroy_tree(g->exit_trees[i][k]);
+    }
+    free(g->exit_trees[i]);
+    int_vec_free( &(g->exits[i]) );
   }
 
-  free(g->info);
+  if (g->mapped == NULL)
+    free(g->info);
 
   free(g->valid_entry);
 
-  destroy_h_table(g->parked_cars);
+  if (g->parked_cars.slots != NULL) {
+    for(i = 0; i < g->parked_cars.size; i++){
+      if (g->parked_cars.slots[i].dist != -1)
+	destroy_p_car(g, g->parked_cars.slots[i].value);
+    }
+    car_map_free(&(g->parked_cars));
+  }
+  destroy_slab(g->cars);
+  destroy_slab(g->p_cars);
 
   for(i = 0; i < g->P ; i++){
-    freeLinkedList(g->park_spaces[i], free);
+    int_vec_free( &(g->park_spaces[i]) );
   }
   free(g->park_spaces);
 
+  for(i = 0; i < g->E * 5; i++){
+    if (g->park_index[i] != NULL)
+      destroy_i_heap(g->park_index[i]);
+  }
+  free(g->park_index);
+  free(g->valid_index);
+  if (g->mapped == NULL) {
+    free(g->park_cell);
+    free(g->park_rank);
+  }
+  free(g->park_keys);
+  free(g->park_wt);
+  free(g->valid_wt);
+  free(g->park_ok);
+
   free(g->valid_floors);
 
   destroy_restrict(g->r_data);
+  free(g->path);
+  destroy_lru(g->trees);
+
+  /* The mapped arrays are released with the model. */
+  if (g->mapped != NULL)
+    destroy_model(g->mapped);
 
   free(g);
 }
 
-void destroy_access( Item a )
+car* new_car( garage *g , char *tag )
 {
-  free(((access*) a)->name);
-  free(((access*) a)->spt);
-  free(((access*) a)->wt);
-  free((access*) a);
+  car *c;
+
+  c = (car*) alloc_slab( g->cars );
+  c->tag = g->own_tags ? copy_tag( tag ) : tag;
+
+  return c;
 }
 
-void destroy_p_car( Item p )
+p_car* new_p_car( garage *g , char *tag , int index_park )
 {
-  free(((p_car*) p)->tag);
-  free((p_car*) p);
+  p_car *pc;
+
+  pc = (p_car*) alloc_slab( g->p_cars );
+  pc->tag = g->own_tags ? copy_tag( tag ) : tag;
+  pc->index_park = index_park;
+
+  return pc;
 }
 
-void destroy_car( Item c )
+void destroy_p_car( garage *g , p_car *p )
 {
-  free(((car*) c)->tag);
-  free((car*) c);
+  if ( g->own_tags )
+    free( p->tag );
+  free_slab( g->p_cars , p );
+}
+
+void destroy_car( garage *g , car *c )
+{
+  if ( g->own_tags )
+    free( c->tag );
+  free_slab( g->cars , c );
+}
+
+/* Returns a copy of a tag, for the records of cars read from a stream. */
+char* copy_tag( char *tag )
+{
+  char *copy;
+
+  copy = (char*) malloc( (strlen(tag) + 1) * sizeof(char) );
+  mem_check(copy);
+  strcpy( copy , tag );
+
+  return copy;
 }
 
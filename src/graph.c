@@ -7,67 +7,233 @@
  *               with specialized search functions embedded.
  *
  *  Implementation details:
- *    The graph structure is represented by a adjencency list. Each vertex,
- *    represent by an integer, corresponds to an index in a array of lists.
- *    The corresponding list stores the vertices to which it is connected,
- *    along with the edges weights.
+ *    The graph is built in two steps. While it is being read, the edges are
+ *    only collected in an array. Then finalize_graph packs them in compressed
+ *    sparse row (CSR) form: the edges of vertex v are the positions
+ *    offset[v] to offset[v+1]-1 of the to/weight arrays. The edges of each
+ *    vertex keep the order an adjacency list would give them (last inserted
+ *    first), so the searches are not affected by the representation.
+ *
+ *    A grid graph stores no edges at all. Its vertices are the cells of a
+ *    N x M x P grid, and the edges are derived when needed from the cell
+ *    kinds kept in the info array (see defs.h): each cell is connected to
+ *    the 4 lateral neighbours it is linked to, and ramps to the cell above.
+ *    The neighbours are given in the order the CSR graph built by read_map
+ *    would give them, so both representations give the same searches.
+ *
+ *    The searches expand vertices by increasing weight and, among equal
+ *    weights, by increasing vertex number. When all edge weights are small
+ *    a bucket queue (Dial's algorithm) is used, otherwise the heap. Grid
+ *    graphs are searched a whole weight layer at a time, on bitboards. The
+ *    queues live in a workspace given to each search, not in the graph.
+ *
+ *    A search tree can be repaired after some vertices are blocked or opened:
+ *    only the subtrees under the blocked vertices are cleared, and the search
+ *    restarts from the vertices around the changes, so the cost depends on
+ *    the region affected and not on the whole graph.
  *
  */
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "graph.h"
+#include "b_queue.h"
+#include "i_heap.h"
+
+/*
+ *  Data Type: edge (private)
+ *  Description: Structure with:
+ *      1) The two vertices connected.
+ *      2) Edge's weight.
+ *  Uses: edges waiting to be packed by finalize_graph
+ */
+typedef struct _edge {
+  int a, b;
+  int weight;
+} edge;
 
 /*
  *  Data Type: graph (semi-private)
  *  Description: Structure with:
  *      1) Number of vertices.
- *      2) Pointer to the list array.
+ *      2) Number of edge entries (each undirected edge counts twice).
+ *      3) CSR arrays: offset (V+1 positions), to and weight (E positions).
+ *
+ *      4) Grid graphs: dimensions and cells info (NULL for CSR graphs).
  *
- *      3) Pointer to the search priority queue.
+ *      5) Edges collected before finalize_graph, their array size and the
+ *         largest weight.
+ *
+ *      6) Whether the CSR arrays belong to a model (not freed with the graph).
+ *
+ *  The graph is never changed by the searches, so several threads can search
+ *  it at the same time, each with its own workspace.
  */
 struct _graph {
-  int V;
-  LinkedList **adj;
+  int V, E;
+  int *offset;
+  int *to;
+  int *weight;
+
+  int N, M, P;
+  int *info;
 
-  p_queue *fringe;
+  edge *pending;
+  int n_pending, max_pending;
+  int max_weight;
+
+  int mapped;
 };
 
+/* Bitboard word, and its number of bits. */
+typedef unsigned long bits;
+#define WORD_BITS ((int) (8 * sizeof(bits)))
+
 /*
- *  Data Type: link (private)
+ *  Data Type: bitboard (private)
  *  Description: Structure with:
- *      1) Number of the vertex connected to.
- *      2) Edge's weight.
- *  Uses: graph connections in adj list
- *        fringe item in pfs
+ *      1) Words per line, and in all floors.
+ *      2) Masks of walls and ramps (fixed), of blocked and open cells (made
+ *         again for each search), and of the vertices reached.
+ *      3) Vertices of the next 3 layers: bits of each layer, with the list
+ *         of its words not empty, and vertices kept in a list instead.
+ *      4) Neighbours of a layer, by lateral and ramp moves and from the list,
+ *         with the list of their words not empty.
+ *  Uses: bit-parallel search of grid graphs
  */
-typedef struct _link {
-  int to;
-  int weight;
-} link;
+typedef struct _bitboard {
+  int W, n_words;
+
+  bits *wall, *ramp;
+  bits *bad, *open;
+  bits *reached;
+
+  bits *front[3];
+  int *front_list[3], n_front[3];
+  int *slow[3], n_slow[3], max_slow[3];
 
-link* new_link( int , int );
-int less_P( Item , Item );
+  bits *near_l, *near_r, *near_s;
+  int *near_list, n_near;
+} bitboard;
+
+/* Word and bit of vertex v in the bitboards. */
+#define word_of(g, b, v) (((v) / (g)->N) * (b)->W + ((v) % (g)->N) / WORD_BITS)
+#define bit_of(g, v) (((bits) 1) << (((v) % (g)->N) % WORD_BITS))
+
+/* Position of the lowest bit set in f (not 0). */
+#ifdef __GNUC__
+#define lowest_bit(f) __builtin_ctzl(f)
+#else
+#define lowest_bit(f) lowest_bit_loop(f)
+#endif
+
+/*
+ *  Data Type: workspace
+ *  Description: Structure with:
+ *      1) Pointer to the search priority queue (of the vertices, by weight),
+ *         and to the bucket queue used instead when the weights are small
+ *         (NULL otherwise).
+ *
+ *      2) Marks and stack used to repair trees (allocated on the first use).
+ *
+ *      3) Bitboards used to search grid graphs (allocated on the first use).
+ *
+ *      4) Arrays where packed trees are unpacked (allocated on the first use,
+ *         only in the workspace of the garage, see workers.c).
+ *  Uses: state of the searches of one thread
+ */
+struct _workspace {
+  i_heap *fringe;
+  b_queue *buckets;
+
+  char *mark;
+  int *stack;
+  int max_stack;
+
+  bitboard *bits;
+
+  int *tree_spt, *tree_wt;
+};
+
+/* Largest edge weight for which the bucket queue is used. */
+#define MAX_DIAL_WEIGHT 8
+
+int reach_vertex( int *info , int M , int N , int *spt , int *wt , int cur , int to , int weight );
+void reach_again( b_queue *q , int *info , int M , int N , int *spt , int *wt , int cur , int to , int weight );
+int adj_graph( graph *g , int v , int *buf_to , int *buf_wt , int **to , int **weight );
+int grid_adj( graph *g , int v , int *to , int *weight );
+void search_heap( graph *g , workspace *w , int *info , int M , int N , int *spt , int *wt );
+void search_dial( graph *g , workspace *w , int *info , int M , int N , int *spt , int *wt );
+void push_stack( workspace *w , int *n , int v );
+void push_path( int **path , int *max_path , int *n , int v );
+int clear_subtree( graph *g , workspace *w , int *spt , int *wt , int root , int n );
+void seed_around( graph *g , workspace *w , int *info , int *spt , int *wt , int v );
+void search_repair( graph *g , workspace *w , int *info , int M , int N , int *spt , int *wt );
+bitboard* new_bitboard( graph *g );
+void destroy_bitboard( bitboard *b );
+void search_bits( graph *g , workspace *w , int *info , int M , int N , int *spt , int *wt , int source );
+void expand_slow( graph *g , bitboard *b , int *info , int M , int N , int *spt , int u );
+int reach_layer( graph *g , int *info , int M , int N , int *spt , int *wt , int v , int d );
+int is_slow( int *info , int M , int N , int *spt , int v );
+int can_move( int *info , int M , int N , int *spt , int u , int v );
+void push_slow( bitboard *b , int l , int v );
+#ifndef __GNUC__
+int lowest_bit_loop( bits f );
+#endif
 
 /* Allocates and inicializes a graph with the size given. */
 graph* new_graph( int V )
 {
   graph *new;
-  int i;
 
   new = (graph*) malloc( sizeof(graph) );
   mem_check(new);
 
   new->V = V;
+  new->E = 0;
+  new->offset = NULL;
+  new->to = NULL;
+  new->weight = NULL;
 
-  new->adj = (LinkedList**) malloc( V * sizeof(LinkedList*) );
-  mem_check(new->adj);
+  new->N = new->M = new->P = 0;
+  new->info = NULL;
 
-  for ( i = 0 ; i < V ; i++ ) {
-    new->adj[i] = initLinkedList();
-  }
+  new->n_pending = 0;
+  new->max_pending = V;
+  new->max_weight = 0;
+  new->mapped = 0;
+  new->pending = (edge*) malloc( new->max_pending * sizeof(edge) );
+  mem_check(new->pending);
+
+  return new;
+}
+
+/* Allocates and inicializes a grid graph, whose edges are derived from the cell kinds in info. */
+graph* new_grid_graph( int N , int M , int P , int *info )
+{
+  graph *new;
+
+  new = (graph*) malloc( sizeof(graph) );
+  mem_check(new);
+
+  new->V = N * M * P;
+  new->E = 0;
+  new->offset = NULL;
+  new->to = NULL;
+  new->weight = NULL;
+
+  new->N = N;
+  new->M = M;
+  new->P = P;
+  new->info = info;
+
+  new->pending = NULL;
+  new->n_pending = new->max_pending = 0;
 
-  new->fringe = new_p_queue( V , less_P , free );
+  /* Lateral moves weight 1 and ramps 2. */
+  new->max_weight = 2;
+  new->mapped = 0;
 
   return new;
 }
@@ -75,161 +241,962 @@ graph* new_graph( int V )
 /* Dealocates the graph resources. */
 void destroy_graph( graph *g )
 {
-  int i;
-
-  for( i = 0 ; i < g->V ; i++ ) {
-    freeLinkedList( g->adj[i] , free );
+  if ( !g->mapped ) {
+    free( g->offset );
+    free( g->to );
+    free( g->weight );
   }
-  free( g->adj );
-
-  destroy_p_queue( g->fringe );
+  free( g->pending );
 
   free( g );
 }
 
+/* Allocates a workspace for searches in the graph given (finalized). */
+workspace* new_workspace( graph *g )
+{
+  workspace *new;
+
+  new = (workspace*) malloc( sizeof(workspace) );
+  mem_check(new);
+
+  new->fringe = new_i_heap( g->V );
+
+  /* With small weights, searches can use a bucket per weight. */
+  if ( g->max_weight > 0 && g->max_weight <= MAX_DIAL_WEIGHT )
+    new->buckets = new_b_queue( g->max_weight + 1 );
+  else
+    new->buckets = NULL;
+
+  new->mark = NULL;
+  new->stack = NULL;
+  new->max_stack = 0;
+
+  new->bits = NULL;
+
+  new->tree_spt = new->tree_wt = NULL;
+
+  return new;
+}
+
+/* Dealocates the workspace resources. */
+void destroy_workspace( workspace *w )
+{
+  destroy_i_heap( w->fringe );
+  if ( w->buckets != NULL )
+    destroy_b_queue( w->buckets );
+  free( w->mark );
+  free( w->stack );
+  if ( w->bits != NULL )
+    destroy_bitboard( w->bits );
+  free( w->tree_spt );
+  free( w->tree_wt );
+
+  free( w );
+}
+
 /* Returns the number of vertexes. */
 int V_graph( graph *g )
 {
   return g->V;
 }
 
-/* Inserts a new bidireccional edge, between vertexes a and b, with the weight given. */
+/* Inserts a new bidireccional edge, between vertexes a and b, with the weight given. 
+   The edge is only stored in the graph when it is finalized. Grid graphs ignore it. */
 void insertE_graph( graph *g , int a , int b , int weight )
 {
-  /* Connects vertice a to b. */
-  g->adj[a] = insertUnsortedLinkedList( g->adj[a] , (Item) new_link(b, weight) );
+  if ( g->info != NULL )
+    return;
 
-  /* Coonects vertice b to a. */
-  g->adj[b] = insertUnsortedLinkedList( g->adj[b] , (Item) new_link(a, weight) );
+  if ( g->n_pending == g->max_pending ) {
+    g->max_pending = 2 * g->max_pending + 1;
+    g->pending = (edge*) realloc( g->pending , g->max_pending * sizeof(edge) );
+    mem_check(g->pending);
+  }
+
+  g->pending[g->n_pending].a = a;
+  g->pending[g->n_pending].b = b;
+  g->pending[g->n_pending].weight = weight;
+  g->n_pending++;
+
+  if ( weight > g->max_weight )
+    g->max_weight = weight;
+}
+
+/* Packs the edges inserted into the CSR arrays. Must be called before searching. */
+void finalize_graph( graph *g )
+{
+  int *fill;
+  edge *e;
+  int i, k;
+
+  if ( g->pending == NULL )
+    return;  /* Already finalized. */
+
+  g->E = 2 * g->n_pending;
+  g->offset = (int*) calloc( g->V + 1 , sizeof(int) );
+  g->to = (int*) malloc( (g->E + 1) * sizeof(int) );
+  g->weight = (int*) malloc( (g->E + 1) * sizeof(int) );
+  mem_check(g->offset);
+  mem_check(g->to);
+  mem_check(g->weight);
+
+  /* Counts the degree of each vertex, and accumulates them into offsets. */
+  for ( i = 0 ; i < g->n_pending ; i++ ) {
+    g->offset[g->pending[i].a + 1]++;
+    g->offset[g->pending[i].b + 1]++;
+  }
+  for ( i = 0 ; i < g->V ; i++ ) {
+    g->offset[i+1] += g->offset[i];
+  }
+
+  /* Fills each vertex range from its end, so the last edge inserted comes first. */
+  fill = (int*) malloc( g->V * sizeof(int) );
+  mem_check(fill);
+  for ( i = 0 ; i < g->V ; i++ ) {
+    fill[i] = g->offset[i+1];
+  }
+
+  for ( i = 0 ; i < g->n_pending ; i++ ) {
+    e = &(g->pending[i]);
+
+    /* Connects vertice a to b. */
+    k = --fill[e->a];
+    g->to[k] = e->b;
+    g->weight[k] = e->weight;
+
+    /* Connects vertice b to a. */
+    k = --fill[e->b];
+    g->to[k] = e->a;
+    g->weight[k] = e->weight;
+  }
+
+  free( fill );
+  free( g->pending );
+  g->pending = NULL;
+  g->n_pending = g->max_pending = 0;
+}
+
+/* Writes the graph (finalized) in a model: its sizes and, if it is not a grid, its edges. */
+void save_graph( graph *g , FILE *fp )
+{
+  int sizes[4];
+
+  sizes[0] = g->V;
+  sizes[1] = g->E;
+  sizes[2] = g->max_weight;
+  sizes[3] = ( g->info != NULL );
+  write_model( fp , sizes , sizeof(sizes) );
+
+  if ( g->info == NULL ) {
+    write_model( fp , g->offset , (g->V + 1) * sizeof(int) );
+    write_model( fp , g->to , g->E * sizeof(int) );
+    write_model( fp , g->weight , g->E * sizeof(int) );
+  }
+}
+
+/* Reads a graph written by save_graph, whose edges stay in the model. Grid graphs are made
+   again from the info given. Returns NULL if the model does not have a graph of that size. */
+graph* map_graph( model *m , int N , int M , int P , int *info )
+{
+  graph *new;
+  int *sizes;
+
+  sizes = (int*) read_model( m , 4 * sizeof(int) );
+  if ( sizes == NULL || sizes[0] != N * M * P )
+    return NULL;
+
+  if ( sizes[3] )
+    return new_grid_graph( N , M , P , info );
+
+  new = (graph*) malloc( sizeof(graph) );
+  mem_check(new);
+
+  new->V = sizes[0];
+  new->E = sizes[1];
+  new->max_weight = sizes[2];
+  new->offset = (int*) read_model( m , (new->V + 1) * sizeof(int) );
+  new->to = (int*) read_model( m , new->E * sizeof(int) );
+  new->weight = (int*) read_model( m , new->E * sizeof(int) );
+
+  new->N = new->M = new->P = 0;
+  new->info = NULL;
+
+  new->pending = NULL;
+  new->n_pending = new->max_pending = 0;
+  new->mapped = 1;
+
+  if ( new->offset == NULL || new->to == NULL || new->weight == NULL ) {
+    free( new );
+    return NULL;
+  }
+
+  return new;
+}
+
+/* Makes the tree t from its source or, when changed is not NULL, repairs it after the flags
+   of the changed vertices were changed. Packed trees are searched unpacked in the workspace. */
+void update_tree( graph *g , workspace *w , int *info , int M , int N , tree *t ,
+		  int source , int *changed , int n_changed )
+{
+  int *spt, *wt;
+
+  if ( is_packed_tree( t ) && w->tree_spt == NULL ) {
+    w->tree_spt = (int*) malloc( g->V * sizeof(int) );
+    w->tree_wt = (int*) malloc( g->V * sizeof(int) );
+    mem_check(w->tree_spt);
+    mem_check(w->tree_wt);
+  }
+
+  open_tree( t , &spt , &wt , w->tree_spt , w->tree_wt , changed != NULL );
+  if ( changed == NULL )
+    generate_spt( g , w , info , M , N , spt , wt , source );
+  else
+    repair_spt( g , w , info , M , N , spt , wt , source , changed , n_changed );
+  close_tree( t , spt , wt );
 }
 
 /* Generates the shortest path tree from a source vertex. */
-void generate_spt( graph *g , int *info , int M , int N , int *spt , int *wt , int source )
+void generate_spt( graph *g , workspace *w , int *info , int M , int N , int *spt , int *wt , int source )
 {
-  LinkedList *aux;
-  link *cur, *adj; /* Completely different use: cur -> fringe item, adj -> graph edge */
   int i = 0;
 
   /* Initializes search vectors and the fringe. */
   for ( i = 0 ; i < g->V ; i++ ) { spt[i] = -1; wt[i] = -1; }
-  clear_p_queue( g->fringe );
+  if ( w->buckets != NULL )
+    clear_b_queue( w->buckets );
+  else
+    clear_i_heap( w->fringe );
 
   /* Check if source is a valid vertex. */
-  if ( get_flag(info[source]) == 0 ) {
-    /* It is. Start the search in it, marking it and adding it to the fringe. */
+  if ( get_flag(info[source]) != 0 )
+    return;
+
+  /* It is. Start the search in it, marking it and adding it to the fringe. */
+  spt[source] = source;
+  wt[source] = 0;
+
+  if ( g->info != NULL )
+    search_bits( g , w , info , M , N , spt , wt , source );
+  else if ( w->buckets != NULL ) {
+    insert_b_queue( w->buckets , source , 0 );
+    search_dial( g , w , info , M , N , spt , wt );
+  } else {
+    insert_i_heap( w->fringe , source , 0 );
+    search_heap( g , w , info , M , N , spt , wt );
+  }
+
+  /* Vertexes that could not be reached are left with wt[v] == -1. */
+}
+
+/* Repairs a tree made by generate_spt from source, after the restriction flag of the
+   vertices in changed was set (blocked) or reset (opened). */
+void repair_spt( graph *g , workspace *w , int *info , int M , int N , int *spt , int *wt ,
+		 int source , int *changed , int n_changed )
+{
+  int i, n = 0, v;
+
+  if ( w->mark == NULL ) {
+    w->mark = (char*) calloc( g->V , sizeof(char) );
+    mem_check(w->mark);
+  }
+  clear_i_heap( w->fringe );
+
+  /* Blocked vertices lose everything that was reached through them. Opened vertices
+     that were marked as invalid can be reached again. The stack keeps all of them. */
+  for ( i = 0 ; i < n_changed ; i++ ) {
+    v = changed[i];
+
+    if ( get_flag(info[v]) != 0 ) {
+      if ( spt[v] >= 0 )
+	n = clear_subtree( g , w , spt , wt , v , n );
+    } else {
+      if ( spt[v] == -2 )
+	spt[v] = -1;
+      push_stack( w , &n , v );
+    }
+  }
+
+  /* An opened source starts the tree again. */
+  if ( spt[source] == -1 && get_flag(info[source]) == 0 ) {
     spt[source] = source;
     wt[source] = 0;
-    insert_p_queue( g->fringe , (Item) new_link(source, 0) );
+    w->mark[source] = 1;
+    insert_i_heap( w->fringe , source , 0 );
+  }
+
+  /* The vertices around the ones cleared or opened are explored again. */
+  for ( i = 0 ; i < n ; i++ ) {
+    seed_around( g , w , info , spt , wt , w->stack[i] );
+  }
+
+  search_repair( g , w , info , M , N , spt , wt );
+}
+
+/* Private. Pushes a vertex to the graph stack, growing it if needed. n is the stack size. */
+void push_stack( workspace *w , int *n , int v )
+{
+  if ( *n == w->max_stack ) {
+    w->max_stack = 2 * w->max_stack + 64;
+    w->stack = (int*) realloc( w->stack , w->max_stack * sizeof(int) );
+    mem_check(w->stack);
+  }
+
+  w->stack[(*n)++] = v;
+}
+
+/* Private. Clears the subtree under root, keeping its vertices in the stack (after the first n).
+   The children of a vertex are the neighbours it was used to reach. Returns the new stack size. */
+int clear_subtree( graph *g , workspace *w , int *spt , int *wt , int root , int n )
+{
+  int buf_to[6], buf_wt[6], *to, *weight;
+  int e, k, first = n, v;
+
+  push_stack( w , &n , root );
+
+  for ( k = first ; k < n ; k++ ) {
+    v = w->stack[k];
+
+    for ( e = adj_graph( g , v , buf_to , buf_wt , &to , &weight ) - 1 ; e >= 0 ; e-- ) {
+      if ( spt[to[e]] == v && to[e] != v )
+	push_stack( w , &n , to[e] );
+    }
+  }
+
+  for ( k = first ; k < n ; k++ ) {
+    spt[w->stack[k]] = -1;
+    wt[w->stack[k]] = -1;
+  }
+
+  return n;
+}
+
+/* Private. Adds to the fringe the reached neighbours of v from which the search can continue. */
+void seed_around( graph *g , workspace *w , int *info , int *spt , int *wt , int v )
+{
+  int buf_to[6], buf_wt[6], *to, *weight;
+  int e, n, u;
+
+  n = adj_graph( g , v , buf_to , buf_wt , &to , &weight );
+  for ( e = 0 ; e < n ; e++ ) {
+    u = to[e];
+
+    /* The sources (accesses) are explored, whatever their id. */
+    if ( spt[u] >= 0 && w->mark[u] == 0 && get_flag(info[u]) == 0 &&
+	 ( spt[u] == u || (get_id(info[u]) != PARK_PLACE_E && get_id(info[u]) != PARK_PLACE_O &&
+			   get_id(info[u]) != INVALID) ) ) {
+      w->mark[u] = 1;
+      insert_i_heap( w->fringe , u , wt[u] );
+    }
   }
+}
+
+/* Private. Priority first search of a repair. Besides reaching the vertices cleared, vertices
+   already reached are corrected when a better vertex reaches them (or their parent changed).
+   A vertex whose weight changes while in the fringe just has its key changed. */
+void search_repair( graph *g , workspace *w , int *info , int M , int N , int *spt , int *wt )
+{
+  int buf_to[6], buf_wt[6], *to, *weight;
+  int e, n, v, p, prev_wt, cur, i, k;
+
+  while( !isEmpty_i_heap( w->fringe ) ) {
+    cur = pop_i_heap( w->fringe );
+    w->mark[cur] = 0;
+
+    /* It may have been cleared while in the fringe. */
+    if ( spt[cur] < 0 )
+      continue;
+
+    n = adj_graph( g , cur , buf_to , buf_wt , &to , &weight );
+    for ( e = 0 ; e < n ; e++ ) {
+      v = to[e];
+      p = spt[v];
+      prev_wt = wt[v];
+
+      if ( p == -1 ) {
+	if ( reach_vertex( info , M , N , spt , wt , cur , v , weight[e] ) == 0 )
+	  continue;
+      } else if ( p < 0 || p == v ) {
+	/* Invalid vertices and sources are kept. */
+	continue;
+      } else if ( p == cur ) {
+	/* Its parent weight may have changed, and so the floor it was reached from. */
+	spt[v] = -1;
+	if ( reach_vertex( info , M , N , spt , wt , cur , v , weight[e] ) == 0 && spt[v] == -1 ) {
+	  /* It can no longer be reached from cur (UP or DOWN): its subtree is cleared. */
+	  spt[v] = p;
+	  k = clear_subtree( g , w , spt , wt , v , 0 );
+	  for ( i = 0 ; i < k ; i++ )
+	    seed_around( g , w , info , spt , wt , w->stack[i] );
+	  continue;
+	}
+      } else if ( wt[cur] < wt[p] || (wt[cur] == wt[p] && cur < p) ) {
+	/* Cur would have reached it first. */
+	spt[v] = -1;
+	if ( reach_vertex( info , M , N , spt , wt , cur , v , weight[e] ) == 0 && spt[v] == -1 ) {
+	  spt[v] = p;
+	  continue;
+	}
+      } else {
+	continue;
+      }
+
+      /* Explore it (again) if it can be explored and its weight changed (or its parent,
+	 for an UP or DOWN, whose moves depend on it). */
+      if ( (p == -1 || wt[v] != prev_wt || (spt[v] != p && (get_id(info[v]) == UP || get_id(info[v]) == DOWN))) &&
+	   get_id(info[v]) != PARK_PLACE_E && get_id(info[v]) != PARK_PLACE_O ) {
+	w->mark[v] = 1;
+	insert_i_heap( w->fringe , v , wt[v] );
+      }
+    }
+  }
+}
+
+/* Private. Priority first search, with the heap as fringe. */
+void search_heap( graph *g , workspace *w , int *info , int M , int N , int *spt , int *wt )
+{
+  int buf_to[6], buf_wt[6], *to, *weight;
+  int e, n, cur;
 
   /* While there are vertices to explore. */
-  while( !isEmpty_p_queue( g->fringe ) ) {
-    cur = (link*) remove_p_queue( g->fringe );
+  while( !isEmpty_i_heap( w->fringe ) ) {
+    cur = pop_i_heap( w->fringe );
 
-    for ( aux = g->adj[cur->to] ; aux != NULL ; aux = getNextNodeLinkedList(aux) ) {
-      adj = (link*) getItemLinkedList( aux );
+    n = adj_graph( g , cur , buf_to , buf_wt , &to , &weight );
+    for ( e = 0 ; e < n ; e++ ) {
+      if ( spt[to[e]] == -1 && reach_vertex( info , M , N , spt , wt , cur , to[e] , weight[e] ) ) {
+	/* Add to queue. */
+	insert_i_heap( w->fringe , to[e] , wt[to[e]] );
+      }
+    }
+  }
+}
 
-      /* As soon as a vertex is reached by priority first search we now it is the best path, 
-	 due to the type of graph (weights are only 1 and 2 - ver relatório). */
-      if ( spt[adj->to] == -1 ) {
-	if ( get_flag(info[adj->to]) != 0 || get_id(info[adj->to]) == INVALID ) {
-	  /* Mark this vertex as invalid. It will not be explored again. */
-	  spt[adj->to] = -2;
+/* Private. Priority first search, with the bucket queue as fringe. The buckets
+   are FIFO, so the vertices of the same weight are not expanded by increasing
+   number: reach_again corrects the vertices that were reached by the wrong one. */
+void search_dial( graph *g , workspace *w , int *info , int M , int N , int *spt , int *wt )
+{
+  int buf_to[6], buf_wt[6], *to, *weight;
+  int cur, key, e, n;
 
-	  /* Does not continue search from it. */
-	} else {
-	  /* Is unexplored and valid (EMPTY (normal, UP ou DOWN) or B_OBJECTIVE). */
+  /* While there are vertices to explore. */
+  while( !isEmpty_b_queue( w->buckets ) ) {
+    cur = remove_b_queue( w->buckets , &key );
 
-	  /* If moved to a UP from a pos in the same floor has to go DOWN. */
-	  if ( get_id(info[cur->to]) == UP && get_id(info[adj->to] != DOWN ) ) {
-	    /* Check if previous pos was in the same floor. */
-	    if ( get_z(spt[cur->to], M, N) == get_z(cur->to, M, N) )
-	      continue;
-	  }
+    /* Its weight was changed after being added, it is in another bucket too. */
+    if ( wt[cur] != key )
+      continue;
 
-	  /* If moved to a DOWN from a pos in the same floor has to go UP. */
-	  if ( get_id(info[cur->to]) == DOWN && get_id(info[adj->to] != UP ) ) {
-	    /* Check if previous pos was in the same floor. */
-	    if ( get_z(spt[cur->to], M, N) == get_z(cur->to, M, N) )
-	      continue;
-	  }
+    n = adj_graph( g , cur , buf_to , buf_wt , &to , &weight );
+    for ( e = 0 ; e < n ; e++ ) {
+      if ( spt[to[e]] == -1 ) {
+	if ( reach_vertex( info , M , N , spt , wt , cur , to[e] , weight[e] ) ) {
+	  /* Add to queue. */
+	  insert_b_queue( w->buckets , to[e] , wt[to[e]] );
+	}
+      } else {
+	reach_again( w->buckets , info , M , N , spt , wt , cur , to[e] , weight[e] );
+      }
+    }
+  }
+}
+
+/*
+ *  Bit-parallel search (grid graphs).
+ *
+ *  Each floor is kept as rows of bits, W words per row: word (z*M + y)*W + k
+ *  holds the cells x = k*WORD_BITS ... of line y of floor z. The search goes
+ *  by weight layers. The vertices of layer d are expanded all at once, with
+ *  shifts for the lateral moves and masks of the ramps for the moves between
+ *  floors, touching only the words with vertices of the layer. Each vertex
+ *  found takes as parent the lowest numbered vertex of the layer that reaches
+ *  it, which is the vertex the other searches would expand first.
+ *
+ *  Ramp cells reached from their own floor can only go on to the other side
+ *  of the ramp (see reach_vertex). They, and the source, are expanded one by
+ *  one, in a list kept per layer.
+ */
+
+/* Private. Adds the bits v to word i of the lateral (near_l) or ramp (near_r) neighbours. */
+#define add_near(b, near, i, v) \
+  if ( (v) != 0 ) { \
+    if ( (b)->near_l[i] == 0 && (b)->near_r[i] == 0 ) \
+      (b)->near_list[(b)->n_near++] = (i); \
+    (near)[i] |= (v); \
+  }
+
+/* Allocates the bitboards of a workspace, with the masks of the cell kinds (which never change). */
+bitboard* new_bitboard( graph *g )
+{
+  bitboard *b;
+  int i, v, size;
+
+  b = (bitboard*) malloc( sizeof(bitboard) );
+  mem_check(b);
+
+  b->W = (g->N + WORD_BITS - 1) / WORD_BITS;
+  b->n_words = g->P * g->M * b->W;
+  size = b->n_words + 1;
+
+  b->wall = (bits*) calloc( size , sizeof(bits) );
+  b->ramp = (bits*) calloc( size , sizeof(bits) );
+  b->bad = (bits*) calloc( size , sizeof(bits) );
+  b->open = (bits*) calloc( size , sizeof(bits) );
+  b->reached = (bits*) calloc( size , sizeof(bits) );
+  b->near_l = (bits*) calloc( size , sizeof(bits) );
+  b->near_r = (bits*) calloc( size , sizeof(bits) );
+  b->near_s = (bits*) calloc( size , sizeof(bits) );
+  b->near_list = (int*) malloc( size * sizeof(int) );
+  mem_check(b->wall);
+  mem_check(b->ramp);
+  mem_check(b->bad);
+  mem_check(b->open);
+  mem_check(b->reached);
+  mem_check(b->near_l);
+  mem_check(b->near_r);
+  mem_check(b->near_s);
+  mem_check(b->near_list);
+  b->n_near = 0;
+
+  for ( i = 0 ; i < 3 ; i++ ) {
+    b->front[i] = (bits*) calloc( size , sizeof(bits) );
+    b->front_list[i] = (int*) malloc( size * sizeof(int) );
+    mem_check(b->front[i]);
+    mem_check(b->front_list[i]);
+    b->n_front[i] = 0;
+
+    b->slow[i] = NULL;
+    b->n_slow[i] = b->max_slow[i] = 0;
+  }
+
+  for ( v = 0 ; v < g->V ; v++ ) {
+    if ( get_kind(g->info[v]) == CELL_WALL )
+      b->wall[word_of(g, b, v)] |= bit_of(g, v);
+    if ( get_kind(g->info[v]) == CELL_RAMP )
+      b->ramp[word_of(g, b, v)] |= bit_of(g, v);
+  }
+
+  return b;
+}
+
+/* Dealocates the bitboards. */
+void destroy_bitboard( bitboard *b )
+{
+  int i;
+
+  free( b->wall );
+  free( b->ramp );
+  free( b->bad );
+  free( b->open );
+  free( b->reached );
+  free( b->near_l );
+  free( b->near_r );
+  free( b->near_s );
+  free( b->near_list );
+  for ( i = 0 ; i < 3 ; i++ ) {
+    free( b->front[i] );
+    free( b->front_list[i] );
+    free( b->slow[i] );
+  }
+
+  free( b );
+}
+
+/* Private. Search of a grid graph by weight layers, from the source already in spt and wt. */
+void search_bits( graph *g , workspace *w , int *info , int M , int N , int *spt , int *wt , int source )
+{
+  bitboard *b;
+  bits f, m, *F;
+  int d, i, k, j, x, y, z, n, l, p, u, base, left;
+  int W, MW, NM = N * M;
+
+  if ( w->bits == NULL )
+    w->bits = new_bitboard( g );
+  b = w->bits;
+  W = b->W;
+  MW = M * W;
+
+  /* Blocked cells can not be reached, open ones can. */
+  memset( b->bad , 0 , b->n_words * sizeof(bits) );
+  memset( b->open , 0 , b->n_words * sizeof(bits) );
+  memset( b->reached , 0 , b->n_words * sizeof(bits) );
+  for ( j = 0 , n = 0 ; j < g->P * M ; j++ ) {
+    for ( x = 0 ; x < N ; x++ , n++ ) {
+      i = j * W + x / WORD_BITS;
+      if ( get_flag(info[n]) != 0 || get_id(info[n]) == INVALID )
+	b->bad[i] |= ((bits) 1) << (x % WORD_BITS);
+      else if ( get_kind(info[n]) != CELL_WALL )
+	b->open[i] |= ((bits) 1) << (x % WORD_BITS);
+    }
+  }
+
+  /* The source is the layer 0. */
+  b->reached[word_of(g, b, source)] |= bit_of(g, source);
+  push_slow( b , 0 , source );
+  left = 1;
 
-	  /* Mark it with the vertex used to reach it. */
-	  spt[adj->to] = cur->to;
+  for ( d = 0 ; left > 0 ; d++ ) {
+    F = b->front[d % 3];
 
-	  /* Calculate total weight to reach it. */
-	  wt[adj->to] = wt[cur->to] + adj->weight;
+    /* Neighbours of the layer vertices kept as bits. */
+    for ( j = 0 ; j < b->n_front[d % 3] ; j++ ) {
+      i = b->front_list[d % 3][j];
+      f = F[i];
+      k = i % W;
+      y = (i / W) % M;
+      z = i / MW;
 
-	  if ( get_id(info[adj->to]) != PARK_PLACE_E && get_id(info[adj->to]) != PARK_PLACE_O ) {
-	    /* It is a valid move vertex (cannot move through a park_place). */
-	    /* Add to queue. */
-	    insert_p_queue( g->fringe , (Item) new_link(adj->to, wt[adj->to]) );
+      add_near( b , b->near_l , i , (f << 1) | (f >> 1) );
+      if ( k + 1 < W ) {
+	add_near( b , b->near_l , i + 1 , f >> (WORD_BITS - 1) );
+      }
+      if ( k > 0 ) {
+	add_near( b , b->near_l , i - 1 , f << (WORD_BITS - 1) );
+      }
+      if ( y > 0 ) {
+	add_near( b , b->near_l , i - W , f );
+      }
+      if ( y + 1 < M ) {
+	add_near( b , b->near_l , i + W , f );
+      }
+      if ( z + 1 < g->P ) {
+	add_near( b , b->near_r , i + MW , f & b->ramp[i] );
+      }
+      if ( z > 0 ) {
+	add_near( b , b->near_r , i - MW , f & b->ramp[i - MW] );
+      }
+    }
+
+    /* Neighbours of the layer vertices kept in the list. */
+    for ( j = 0 ; j < b->n_slow[d % 3] ; j++ ) {
+      expand_slow( g , b , info , M , N , spt , b->slow[d % 3][j] );
+    }
+    left -= b->n_front[d % 3] + b->n_slow[d % 3];
+    b->n_slow[d % 3] = 0;
+
+    /* Blocked neighbours are marked invalid, the open ones not reached yet are reached. */
+    for ( j = 0 ; j < b->n_near ; j++ ) {
+      i = b->near_list[j];
+      k = i % W;
+      y = (i / W) % M;
+      z = i / MW;
+      base = (i / W) * N + k * WORD_BITS;
+
+      f = (b->near_l[i] & b->bad[i] & ~b->wall[i]) | (b->near_r[i] & b->bad[i]);
+      while ( f != 0 ) {
+	n = base + lowest_bit(f);
+	if ( spt[n] == -1 )
+	  spt[n] = -2;
+	f &= f - 1;
+      }
+
+      f = (b->near_l[i] | b->near_r[i]) & b->open[i] & ~b->reached[i];
+      b->reached[i] |= f;
+
+      while ( f != 0 ) {
+	p = lowest_bit(f);
+	m = ((bits) 1) << p;
+	n = base + p;
+	x = k * WORD_BITS + p;
+	f &= f - 1;
+
+	if ( (b->near_s[i] & m) != 0 ) {
+	  /* Reached by a vertex of the list, all the neighbours are compared. */
+	  if ( reach_layer( g , info , M , N , spt , wt , n , d ) == 0 )
+	    continue;
+	} else {
+	  /* Only vertices of the layer bits reach it: the parent is the first neighbour (by
+	     number) in them. Lateral moves are always linked, the vertices in bits are free. */
+	  if ( z > 0 && (F[i - MW] & b->ramp[i - MW] & m) != 0 ) {
+	    u = n - NM;
+	  } else if ( y > 0 && (F[i - W] & m) != 0 ) {
+	    u = n - N;
+	  } else if ( x > 0 && (p > 0 ? (F[i] & (m >> 1)) : (F[i - 1] >> (WORD_BITS - 1))) != 0 ) {
+	    u = n - 1;
+	  } else if ( x + 1 < N && (p < WORD_BITS - 1 ? (F[i] & (m << 1)) : (F[i + 1] & 1)) != 0 ) {
+	    u = n + 1;
+	  } else if ( y + 1 < M && (F[i + W] & m) != 0 ) {
+	    u = n + N;
+	  } else {
+	    u = n + NM;
 	  }
 
-	  /* If it was a B objective the sub-path ends in it. */
+	  spt[n] = u;
+	  wt[n] = d + ( (u - n == NM || n - u == NM) ? 2 : 1 );
+	  if ( get_id(info[n]) == PARK_PLACE_E || get_id(info[n]) == PARK_PLACE_O )
+	    continue;
+	}
+
+	/* Goes to the layer of its weight, in the list if it can only go on to a ramp.
+	   left counts the words and list vertices of the layers to come. */
+	l = wt[n] % 3;
+	if ( is_slow( info , M , N , spt , n ) ) {
+	  push_slow( b , l , n );
+	  left++;
+	} else {
+	  if ( b->front[l][i] == 0 ) {
+	    b->front_list[l][b->n_front[l]++] = i;
+	    left++;
+	  }
+	  b->front[l][i] |= m;
 	}
       }
+
+      b->near_l[i] = b->near_r[i] = b->near_s[i] = 0;
     }
+    b->n_near = 0;
 
-    free(cur);
+    /* The layer is done. */
+    for ( j = 0 ; j < b->n_front[d % 3] ; j++ ) {
+      F[b->front_list[d % 3][j]] = 0;
+    }
+    b->n_front[d % 3] = 0;
   }
+}
 
-  /* Fringe should have been emptied, but just in case. */
-  clear_p_queue( g->fringe );
+/* Private. Adds the neighbours of a vertex of the list to the bits of the neighbours, or marks
+   them invalid, as reach_vertex would. */
+void expand_slow( graph *g , bitboard *b , int *info , int M , int N , int *spt , int u )
+{
+  int to[6], weight[6];
+  int e, n, v;
 
-  /* Vertexes that could not be reached are left with wt[v] == -1. */
+  n = grid_adj( g , u , to , weight );
+  for ( e = 0 ; e < n ; e++ ) {
+    v = to[e];
+    if ( spt[v] != -1 )
+      continue;
+
+    if ( get_flag(info[v]) != 0 || get_id(info[v]) == INVALID ) {
+      spt[v] = -2;
+    } else if ( can_move( info , M , N , spt , u , v ) ) {
+      add_near( b , b->near_r , word_of(g, b, v) , bit_of(g, v) );
+      b->near_s[word_of(g, b, v)] |= bit_of(g, v);
+    }
+  }
 }
 
-/* Prints to a LinkedList the path A->B->C, using the 2 short path trees given. */
-LinkedList* get_path( int vB , int *AtoB , int *BtoC )
+/* Private. Gives vertex v, found in layer d, the lowest numbered vertex of the layer that can
+   move to it as parent. Returns 1 if the search goes on from v. */
+int reach_layer( graph *g , int *info , int M , int N , int *spt , int *wt , int v , int d )
 {
-  LinkedList *list, *aux;
-  int v;
+  int to[6], weight[6];
+  int e, n, u, best = -1, best_wt = 0;
 
-  /* Initializes list with vB vertex. */
-  list = initLinkedList();
-  aux = list = insertUnsortedLinkedList( list , (Item) new_int(vB) );
+  n = grid_adj( g , v , to , weight );
+  for ( e = 0 ; e < n ; e++ ) {
+    u = to[e];
+    if ( spt[u] < 0 || wt[u] != d || (best != -1 && u > best) )
+      continue;
+    if ( spt[u] != u && (get_id(info[u]) == PARK_PLACE_E || get_id(info[u]) == PARK_PLACE_O) )
+      continue;
+    if ( !can_move( info , M , N , spt , u , v ) )
+      continue;
 
-  /* Adds vertexes to reach C after vB in the list. */
-  v = BtoC[vB];
-  while ( v != BtoC[v] ) {
-    insertAfterLinkedList( aux , (Item) new_int(v) );
-    aux = getNextNodeLinkedList( aux );
+    best = u;
+    best_wt = weight[e];
+  }
+
+  spt[v] = best;
+  wt[v] = d + best_wt;
+
+  return ( get_id(info[v]) != PARK_PLACE_E && get_id(info[v]) != PARK_PLACE_O );
+}
+
+/* Private. Checks if a ramp cell can only go on to the other side of the ramp: if it was
+   reached from its own floor (as in reach_vertex). */
+int is_slow( int *info , int M , int N , int *spt , int v )
+{
+  return ( (get_id(info[v]) == UP || get_id(info[v]) == DOWN) &&
+	   get_z(spt[v], M, N) == get_z(v, M, N) );
+}
 
-    v = BtoC[v];
+/* Private. Checks if the search can go from u (already reached) to v, as in reach_vertex. */
+int can_move( int *info , int M , int N , int *spt , int u , int v )
+{
+  if ( get_id(info[u]) == UP && get_id(info[v]) != DOWN && is_slow( info , M , N , spt , u ) )
+    return 0;
+  if ( get_id(info[u]) == DOWN && get_id(info[v]) != UP && is_slow( info , M , N , spt , u ) )
+    return 0;
+
+  return 1;
+}
+
+/* Private. Adds a vertex to the list of layer l. */
+void push_slow( bitboard *b , int l , int v )
+{
+  if ( b->n_slow[l] == b->max_slow[l] ) {
+    b->max_slow[l] = 2 * b->max_slow[l] + 16;
+    b->slow[l] = (int*) realloc( b->slow[l] , b->max_slow[l] * sizeof(int) );
+    mem_check(b->slow[l]);
   }
-  insertAfterLinkedList( aux , (Item) new_int(v) );
 
-  /* Adds vertexes from A before vB in the list. */
-  v = AtoB[vB];
-  while ( v != AtoB[v] ) {
-    list = insertUnsortedLinkedList( list , (Item) new_int(v) );
+  b->slow[l][b->n_slow[l]++] = v;
+}
+
+#ifndef __GNUC__
+/* Private. Position of the lowest bit set in f (not 0). */
+int lowest_bit_loop( bits f )
+{
+  int x;
 
-    v = AtoB[v];
+  for ( x = 0 ; (f & 1) == 0 ; x++ ) {
+    f >>= 1;
   }
-  list = insertUnsortedLinkedList( list , (Item) new_int(v) );
 
-  return list;
+  return x;
 }
+#endif
 
-link* new_link( int to , int weight )
+/* Private. Gets the edges of vertex v: points to and weight to them and returns how many.
+   CSR graphs give their own arrays, grid graphs fill the buffers given (6 positions). */
+int adj_graph( graph *g , int v , int *buf_to , int *buf_wt , int **to , int **weight )
 {
-  link *new;
+  if ( g->info != NULL ) {
+    *to = buf_to;
+    *weight = buf_wt;
+    return grid_adj( g , v , buf_to , buf_wt );
+  }
 
-  new = (link*) malloc( sizeof(link) );
-  mem_check(new);
+  *to = g->to + g->offset[v];
+  *weight = g->weight + g->offset[v];
+  return g->offset[v + 1] - g->offset[v];
+}
 
-  new->to = to;
-  new->weight = weight;
+/* Private. Derives the edges of a grid graph vertex from the cell kinds. The order is the one
+   read_map inserts them, reversed: line below, next column, floor above, previous column,
+   line above, floor below. */
+int grid_adj( graph *g , int v , int *to , int *weight )
+{
+  int *info = g->info, N = g->N, NM = g->N * g->M;
+  int x = v % N, y = (v % NM) / N, z = v / NM;
+  int kind = get_kind(info[v]), n = 0;
 
-  return new;
+  if ( y > 0 && linked_kinds(kind, get_kind(info[v - N])) ) {
+    to[n] = v - N; weight[n++] = 1;
+  }
+  if ( x + 1 < N && linked_kinds(kind, get_kind(info[v + 1])) ) {
+    to[n] = v + 1; weight[n++] = 1;
+  }
+  if ( kind == CELL_RAMP && z + 1 < g->P ) {
+    to[n] = v + NM; weight[n++] = 2;
+  }
+  if ( x > 0 && linked_kinds(kind, get_kind(info[v - 1])) ) {
+    to[n] = v - 1; weight[n++] = 1;
+  }
+  if ( y + 1 < g->M && linked_kinds(kind, get_kind(info[v + N])) ) {
+    to[n] = v + N; weight[n++] = 1;
+  }
+  if ( z > 0 && get_kind(info[v - NM]) == CELL_RAMP ) {
+    to[n] = v - NM; weight[n++] = 2;
+  }
+
+  return n;
 }
 
-int less_P( Item i1 , Item i2 )
+/* Private. Tries to reach an unexplored vertex (to), from cur. Returns 1 if it must be added to the fringe. */
+int reach_vertex( int *info , int M , int N , int *spt , int *wt , int cur , int to , int weight )
 {
-  if ( ((link*) i1)->weight > ((link*) i2)->weight )
-    return 1;
+  /* As soon as a vertex is reached by priority first search we now it is the best path, 
+     due to the type of graph (weights are only 1 and 2 - ver relatório). */
+  if ( get_flag(info[to]) != 0 || get_id(info[to]) == INVALID ) {
+    /* Mark this vertex as invalid. It will not be explored again. */
+    spt[to] = -2;
+
+    /* Does not continue search from it. */
+    return 0;
+  }
+
+  /* Is unexplored and valid (EMPTY (normal, UP ou DOWN) or B_OBJECTIVE). */
+
+  /* If moved to a UP from a pos in the same floor has to go DOWN. */
+  if ( get_id(info[cur]) == UP && get_id(info[to]) != DOWN ) {
+    /* Check if previous pos was in the same floor. */
+    if ( get_z(spt[cur], M, N) == get_z(cur, M, N) )
+      return 0;
+  }
+
+  /* If moved to a DOWN from a pos in the same floor has to go UP. */
+  if ( get_id(info[cur]) == DOWN && get_id(info[to]) != UP ) {
+    /* Check if previous pos was in the same floor. */
+    if ( get_z(spt[cur], M, N) == get_z(cur, M, N) )
+      return 0;
+  }
+
+  /* Mark it with the vertex used to reach it. */
+  spt[to] = cur;
+
+  /* Calculate total weight to reach it. */
+  wt[to] = wt[cur] + weight;
+
+  /* It is a valid move vertex (cannot move through a park_place). */
+  /* If it was a B objective the sub-path ends in it. */
+  return ( get_id(info[to]) != PARK_PLACE_E && get_id(info[to]) != PARK_PLACE_O );
+}
+
+/* Private. A vertex already reached from a vertex with the same weight as cur, but
+   a bigger number, is reached from cur instead (as the heap order would do). */
+void reach_again( b_queue *q , int *info , int M , int N , int *spt , int *wt , int cur , int to , int weight )
+{
+  int prev = spt[to], prev_wt = wt[to];
+
+  /* Invalid vertices, sources and vertices reached with a lower weight are kept. */
+  if ( prev < 0 || prev == to || wt[prev] != wt[cur] || prev <= cur )
+    return;
+
+  spt[to] = -1;
+  if ( reach_vertex( info , M , N , spt , wt , cur , to , weight ) ) {
+    /* If its weight changed, it has to be explored from another bucket. */
+    if ( wt[to] != prev_wt )
+      insert_b_queue( q , to , wt[to] );
+  } else if ( spt[to] == -1 ) {
+    /* Cur cannot move to it, keep the previous path. */
+    spt[to] = prev;
+    wt[to] = prev_wt;
+  }
+}
+
+/* Writes to the buffer given the path A->B->C, using the 2 short path trees given, and
+   returns its length. The buffer (of *max_path ints) grows if needed, so a buffer kept
+   from one path to the next does not allocate. */
+int get_path( int vB , tree *AtoB , tree *BtoC , int **path , int *max_path )
+{
+  int v, n = 0, i, j, aux;
+
+  /* Adds vB and the vertexes from A before it, backwards. */
+  v = vB;
+  push_path( path , max_path , &n , v );
+  while ( v != parent_tree( AtoB , v ) ) {
+    v = parent_tree( AtoB , v );
+    push_path( path , max_path , &n , v );
+  }
+
+  /* Puts them in order, from A to vB. */
+  for ( i = 0 , j = n - 1 ; i < j ; i++ , j-- ) {
+    aux = (*path)[i];
+    (*path)[i] = (*path)[j];
+    (*path)[j] = aux;
+  }
+
+  /* Adds the vertexes to reach C after vB. */
+  v = vB;
+  do {
+    v = parent_tree( BtoC , v );
+    push_path( path , max_path , &n , v );
+  } while ( v != parent_tree( BtoC , v ) );
+
+  return n;
+}
+
+/* Private. Adds a vertex to the path buffer, growing it if needed. n is the path length. */
+void push_path( int **path , int *max_path , int *n , int v )
+{
+  if ( *n == *max_path ) {
+    *max_path = 2 * *max_path + 64;
+    *path = (int*) realloc( *path , *max_path * sizeof(int) );
+    mem_check(*path);
+  }
 
-  return 0;
+  (*path)[(*n)++] = v;
 }
 
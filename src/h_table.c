@@ -3,12 +3,21 @@
  *
  *  Authors: Miguel Malaca & Miguel Pinho
  *
- *  Description: C-implentation of an hash table, by list dispersion.
+ *  Description: C-implentation of an hash table, by open addressing.
  *
  *  Implementation details:
- *    The hash table, initialized wiyh a certain size and hash function, is 
- *    implemented by an array of lists. The elements givens are dispersed 
- *    using the hash fuction throughout the various lists.
+ *    The hash table, initialized with a certain size and hash function, is
+ *    implemented by an array of slots, a power of two in size. Each element
+ *    is placed in the first slot free after the one its hash points to
+ *    (linear probing), and keeps its hash and its distance to that slot.
+ *
+ *    The slots are kept in Robin Hood order: while an element is inserted,
+ *    it takes the place of any element closer to its own slot, which then
+ *    goes on. The distances stay short and even, and a search stops as soon
+ *    as it passes elements closer to their slots than it would be. Removed
+ *    elements are filled by shifting the following ones back.
+ *
+ *    The table doubles its size when it is 7/8 full.
  *
  */
 
@@ -17,50 +26,56 @@
 #include "h_table.h"
 
 /*
- *  Data Type: graph (semi-private)
+ *  Data Type: h_slot (private)
+ *  Description: Structure with:
+ *      1) Item stored, and its key.
+ *      2) Key's hash.
+ *      3) Distance to the slot of the hash (-1 if the slot is empty).
+ */
+typedef struct _h_slot {
+  Item this;
+  Item key;
+  unsigned long hash;
+  int dist;
+} h_slot;
+
+/*
+ *  Data Type: h_table (semi-private)
  *  Description: Structure with:
- *      1) Size of the hash_table.
- *      2) Lists array.
- *      3) Hash functions.
- *      3) Compare Item function.
+ *      1) Number of slots (a power of two) and of elements.
+ *      2) Slots array.
+ *      3) Hash function.
+ *      4) Compare Item function.
  *      5) Free Item function.
  */
 struct _h_table {
-  int size;
-  LinkedList **buckets;
-  int (*hash_function)(Item, int);
+  int size, n_elements;
+  h_slot *slots;
+  unsigned long (*hash_function)(Item);
   int (*compare_function)(Item, Item);
   void (*free_item)(Item);
 };
 
-/*
- *  Data Type: h_item (private)
- *  Description: Structure with:
- *      1) Item stored.
- *      2) Item's key.
- */
-typedef struct _h_item {
-  Item this;
-  Item key;
-} h_item;
-
-h_item *new_h_item( Item this , Item key );
+h_slot* new_slots( int size );
+void place_h_table( h_table *ht , h_slot s );
+void grow_h_table( h_table *ht );
+int find_h_table( h_table *ht , Item key , unsigned long hash );
 
-/* Initializes hash_table. */
-h_table* new_h_table( int size , int (*hash_function)(Item, int) , int (*compare_function)(Item, Item) , void (*free_item)(Item) )
+/* Initializes hash_table, with room for about size elements before it grows. */
+h_table* new_h_table( int size , unsigned long (*hash_function)(Item) , int (*compare_function)(Item, Item) , void (*free_item)(Item) )
 {
   h_table *new;
-  int i;
 
   new = (h_table*) malloc( sizeof(h_table) );
   mem_check(new);
 
-  new->size = size;
-  new->buckets = (LinkedList**) malloc( size * sizeof(LinkedList*) );
-  for ( i = 0 ; i < size ; i++ ) {
-    new->buckets[i] = initLinkedList();
+  new->size = 8;
+  while ( new->size < size ) {
+    new->size *= 2;
   }
-  
+  new->n_elements = 0;
+  new->slots = new_slots( new->size );
+
   new->hash_function = hash_function;
   new->compare_function = compare_function;
   new->free_item = free_item;
@@ -72,100 +87,145 @@ h_table* new_h_table( int size , int (*hash_function)(Item, int) , int (*compare
 void destroy_h_table( h_table *ht )
 {
   clear_h_table(ht);
-  free(ht->buckets);
-    
+  free(ht->slots);
+
   free(ht);
 }
 
-/* Clear the hash_table. */
+/* Clear the hash_table (freeing the elements, if a free Item function was given). */
 void clear_h_table( h_table *ht )
 {
   int i;
-  LinkedList *l;
-  h_item *hi;
-  
-  for ( i = 0 ; i < ht->size ; i++ ) {
-    l = ht->buckets[i];
-    
-    while ( l != NULL ) {
-      hi = (h_item*) getItemLinkedList(l);
-
-      ht->free_item(hi->this);
-      free(hi);
 
-      l = removeHeadLinkedList(l);
+  for ( i = 0 ; i < ht->size ; i++ ) {
+    if ( ht->slots[i].dist != -1 ) {
+      if ( ht->free_item != NULL )
+        ht->free_item(ht->slots[i].this);
+      ht->slots[i].dist = -1;
     }
-
-    ht->buckets[i] = NULL;
   }
+
+  ht->n_elements = 0;
 }
 
 /* Insert an element in the hash. */
 void put_h_table( h_table *ht , Item this , Item key )
 {
-  int pos = ht->hash_function(key, ht->size);
+  h_slot s;
+
+  if ( 8 * (ht->n_elements + 1) > 7 * ht->size )
+    grow_h_table(ht);
 
-  ht->buckets[pos] = insertUnsortedLinkedList( ht->buckets[pos] , (Item*) new_h_item(this, key));
+  s.this = this;
+  s.key = key;
+  s.hash = ht->hash_function(key);
+  s.dist = 0;
+
+  place_h_table(ht, s);
+  ht->n_elements++;
 }
 
 /* Get an element from the hash, but do not remove it. */
 Item get_h_table( h_table *ht , Item key )
 {
-  LinkedList *list;
-  h_item *hi;
-  int pos = ht->hash_function(key, ht->size);
-  
-  for ( list = ht->buckets[pos] ; list != NULL ; list = getNextNodeLinkedList(list) ) {
-    hi = (h_item*) getItemLinkedList(list);
-    
-    if ( ht->compare_function(key, hi->key) ) {
-      return hi->this;
-    }
-  }
+  int pos = find_h_table(ht, key, ht->hash_function(key));
 
-  return NULL;
+  return pos == -1 ? NULL : ht->slots[pos].this;
 }
 
 /* Remove and return an element from the hash. */
 Item remove_h_table( h_table *ht , Item key )
 {
-  LinkedList *aux, *prev;
-  h_item *hi;
   Item this;
-  int pos = ht->hash_function(key, ht->size);
-  
-  for ( aux = ht->buckets[pos], prev = NULL ; aux != NULL ; prev = aux, aux = getNextNodeLinkedList(aux) ) {
-    hi = (h_item*) getItemLinkedList(aux);
-    
-    if ( ht->compare_function(key, hi->key) ) {
-      this = hi->this;
-
-      free(hi);
-
-      if ( prev == NULL ) {
-	/* Node is at the list beginning. */
-	ht->buckets[pos] = removeHeadLinkedList(ht->buckets[pos]);
-      } else {
-	/* Node is in the middle (or end) of the list. */
-	removeMiddleLinkedList(prev);
-      }
-      
-      return this;
+  int pos, next, mask = ht->size - 1;
+
+  pos = find_h_table(ht, key, ht->hash_function(key));
+  if ( pos == -1 )
+    return NULL;
+
+  this = ht->slots[pos].this;
+
+  /* Shift back the following elements, until an empty slot or one in its own slot. */
+  next = (pos + 1) & mask;
+  while ( ht->slots[next].dist > 0 ) {
+    ht->slots[pos] = ht->slots[next];
+    ht->slots[pos].dist--;
+    pos = next;
+    next = (next + 1) & mask;
+  }
+  ht->slots[pos].dist = -1;
+
+  ht->n_elements--;
+
+  return this;
+}
+
+/* Private. Returns the slot of the element with the key (and hash) given, or -1. */
+int find_h_table( h_table *ht , Item key , unsigned long hash )
+{
+  int pos, dist, mask = ht->size - 1;
+
+  pos = (int) (hash & mask);
+  for ( dist = 0 ; ht->slots[pos].dist >= dist ; dist++ ) {
+    if ( ht->slots[pos].hash == hash && ht->compare_function(key, ht->slots[pos].key) )
+      return pos;
+    pos = (pos + 1) & mask;
+  }
+
+  return -1;
+}
+
+/* Private. Places an element, moving forward the ones closer to their slots. */
+void place_h_table( h_table *ht , h_slot s )
+{
+  h_slot aux;
+  int pos, mask = ht->size - 1;
+
+  pos = (int) ((s.hash + s.dist) & mask);
+  while ( ht->slots[pos].dist != -1 ) {
+    if ( ht->slots[pos].dist < s.dist ) {
+      aux = ht->slots[pos];
+      ht->slots[pos] = s;
+      s = aux;
     }
+    pos = (pos + 1) & mask;
+    s.dist++;
   }
 
-  return NULL;
+  ht->slots[pos] = s;
 }
 
-h_item *new_h_item( Item this , Item key )
+/* Private. Doubles the number of slots, placing all the elements again. */
+void grow_h_table( h_table *ht )
 {
-  h_item *new;
+  h_slot *old = ht->slots;
+  int i, old_size = ht->size;
+
+  ht->size *= 2;
+  ht->slots = new_slots( ht->size );
+
+  for ( i = 0 ; i < old_size ; i++ ) {
+    if ( old[i].dist != -1 ) {
+      old[i].dist = 0;
+      place_h_table(ht, old[i]);
+    }
+  }
+
+  free(old);
+}
 
-  new = (h_item*) malloc( sizeof(h_item) );
+/* Private. Allocates an array of empty slots. */
+h_slot* new_slots( int size )
+{
+  h_slot *new;
+  int i;
+
+  new = (h_slot*) malloc( size * sizeof(h_slot) );
   mem_check(new);
 
-  new->this = this;
-  new->key = key;
-  
+  for ( i = 0 ; i < size ; i++ ) {
+    new[i].dist = -1;
+  }
+
   return new;
 }
@@ -0,0 +1,248 @@
+/*
+ *  File name: i_heap.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: C-Implementation of an indexed priority queue of the
+ *      integers 0 to n-1, each one with an integer key. Has functions to
+ *      insert, remove any of them, and access or remove the one with the
+ *      lowest key.
+ *
+ *  Implementation details:
+ *    D-ary heap (I_HEAP_D children per node), with the position of each
+ *    integer in the heap kept in an array, so any integer can be removed or
+ *    have its key changed, and is never in the heap twice. Equal keys are
+ *    ordered by the integers themselves.
+ *
+ *    The heap keeps each key next to its integer, so the comparisons do not
+ *    read another array. Moving an entry up or down shifts the others into
+ *    its place, and writes it only once, where it stops.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "i_heap.h"
+
+/*
+ *  Data Type: i_entry (private)
+ *  Description: Structure with:
+ *      1) Key of the integer.
+ *      2) Integer.
+ */
+typedef struct _i_entry {
+  int key;
+  int this;
+} i_entry;
+
+/*
+ *  Data Type: i_heap (semi-private)
+ *  Description: Structure with:
+ *      1) Number of integers it can hold, and number in the heap.
+ *      2) Heap array of integers, with their keys.
+ *      3) Position of each integer in the heap (-1 if it is not there).
+ */
+struct _i_heap {
+  int n, n_elements;
+  i_entry *heap;
+  int *pos;
+};
+
+/* Private. Compares entries by key, and then by integer. */
+#define less_I(a, b) ((a).key < (b).key || ((a).key == (b).key && (a).this < (b).this))
+
+void fixUp_I( i_heap *h , int k );
+void fixDown_I( i_heap *h , int k );
+
+/* Interface function: Initializes an empty i_heap for the integers 0 to n-1. */
+i_heap* new_i_heap( int n )
+{
+  i_heap *h;
+  int i;
+
+  h = (i_heap*) malloc( sizeof(i_heap) );
+  mem_check(h);
+
+  h->n = n;
+  h->n_elements = 0;
+  h->heap = (i_entry*) malloc( (n + 1) * sizeof(i_entry) );
+  h->pos = (int*) malloc( (n + 1) * sizeof(int) );
+  mem_check(h->heap);
+  mem_check(h->pos);
+
+  for ( i = 0 ; i < n ; i++ ) {
+    h->pos[i] = -1;
+  }
+
+  return h;
+}
+
+/* Interface function: Deallocates the whole i_heap. */
+void destroy_i_heap( i_heap *h )
+{
+  free( h->heap );
+  free( h->pos );
+  free( h );
+}
+
+/* Interface function: removes all integers. */
+void clear_i_heap( i_heap *h )
+{
+  int i;
+
+  for ( i = 0 ; i < h->n_elements ; i++ ) {
+    h->pos[h->heap[i].this] = -1;
+  }
+  h->n_elements = 0;
+}
+
+/* Interface function: makes the heap again with the integers whose key is not -1 (keys has n
+   positions), in linear time. */
+void build_i_heap( i_heap *h , int *keys )
+{
+  int i;
+
+  clear_i_heap( h );
+  for ( i = 0 ; i < h->n ; i++ ) {
+    if ( keys[i] == -1 )
+      continue;
+
+    h->heap[h->n_elements].key = keys[i];
+    h->heap[h->n_elements].this = i;
+    h->pos[i] = h->n_elements++;
+  }
+
+  /* From the parent of the last entry up. */
+  for ( i = h->n_elements > 1 ? (h->n_elements - 2) / I_HEAP_D : -1 ; i >= 0 ; i-- ) {
+    fixDown_I( h , i );
+  }
+}
+
+/* Interface function: inserts an integer with the key given, or changes its key if it is there. */
+void insert_i_heap( i_heap *h , int this , int key )
+{
+  int k = h->pos[this], old;
+
+  if ( k == -1 ) {
+    k = h->n_elements++;
+    h->heap[k].this = this;
+    h->heap[k].key = key;
+    h->pos[this] = k;
+    fixUp_I( h , k );
+    return;
+  }
+
+  old = h->heap[k].key;
+  h->heap[k].key = key;
+  if ( key < old )
+    fixUp_I( h , k );
+  else if ( key > old )
+    fixDown_I( h , k );
+}
+
+/* Interface function: removes an integer, if it is there. */
+void remove_i_heap( i_heap *h , int this )
+{
+  int k = h->pos[this];
+
+  if ( k == -1 )
+    return;
+
+  h->pos[this] = -1;
+  h->n_elements--;
+  if ( k != h->n_elements ) {
+    /* The last entry fills the place, and goes up or down from it. */
+    h->heap[k] = h->heap[h->n_elements];
+    h->pos[h->heap[k].this] = k;
+    if ( k > 0 && less_I( h->heap[k] , h->heap[(k - 1) / I_HEAP_D] ) )
+      fixUp_I( h , k );
+    else
+      fixDown_I( h , k );
+  }
+}
+
+/* Interface function: removes and returns the integer with the lowest key (-1 if empty). */
+int pop_i_heap( i_heap *h )
+{
+  int this;
+
+  if ( h->n_elements == 0 )
+    return -1;
+
+  this = h->heap[0].this;
+  h->pos[this] = -1;
+  h->n_elements--;
+  if ( h->n_elements > 0 ) {
+    h->heap[0] = h->heap[h->n_elements];
+    h->pos[h->heap[0].this] = 0;
+    fixDown_I( h , 0 );
+  }
+
+  return this;
+}
+
+/* Interface function: returns the integer with the lowest key (-1 if empty). */
+int min_i_heap( i_heap *h )
+{
+  if ( h->n_elements == 0 )
+    return -1;
+
+  return h->heap[0].this;
+}
+
+/* Interface function: returns the key of an integer in the heap. */
+int key_i_heap( i_heap *h , int this )
+{
+  return h->heap[h->pos[this]].key;
+}
+
+int isEmpty_i_heap( i_heap *h )
+{
+  return h->n_elements == 0;
+}
+
+/* Private. Moves the entry in position k up while it is lower than its parent. */
+void fixUp_I( i_heap *h , int k )
+{
+  i_entry e = h->heap[k];
+  int p;
+
+  while ( k > 0 ) {
+    p = (k - 1) / I_HEAP_D;
+    if ( !less_I( e , h->heap[p] ) )
+      break;
+
+    h->heap[k] = h->heap[p];
+    h->pos[h->heap[k].this] = k;
+    k = p;
+  }
+
+  h->heap[k] = e;
+  h->pos[e.this] = k;
+}
+
+/* Private. Moves the entry in position k down while a child is lower. */
+void fixDown_I( i_heap *h , int k )
+{
+  i_entry e = h->heap[k];
+  int j, c, last;
+
+  while ( I_HEAP_D * k + 1 < h->n_elements ) {
+    /* Lowest child. */
+    j = I_HEAP_D * k + 1;
+    last = j + I_HEAP_D < h->n_elements ? j + I_HEAP_D : h->n_elements;
+    for ( c = j + 1 ; c < last ; c++ ) {
+      if ( less_I( h->heap[c] , h->heap[j] ) )
+	j = c;
+    }
+    if ( !less_I( h->heap[j] , e ) )
+      break;
+
+    h->heap[k] = h->heap[j];
+    h->pos[h->heap[k].this] = k;
+    k = j;
+  }
+
+  h->heap[k] = e;
+  h->pos[e.this] = k;
+}
@@ -0,0 +1,180 @@
+/*
+ *  File name: lru.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: C-Implementation of a least recently used (LRU) cache of the
+ *      integers 0 to n-1, each one with a size, within a size budget. Has
+ *      functions to use an integer, to add and remove it, and to choose the
+ *      ones to evict.
+ *
+ *  Implementation details:
+ *    The integers in the cache are in a doubly linked list, kept in arrays,
+ *    from the most to the least recently used. The most recently used one is
+ *    never evicted, so two integers used together are both kept, whatever
+ *    the budget.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "lru.h"
+
+/*
+ *  Data Type: lru (semi-private)
+ *  Description: Structure with:
+ *      1) Number of integers, budget (0 for none) and size used.
+ *      2) First (most recent) and last integers of the list, and the links
+ *         of each integer (-1 at the ends).
+ *      3) Size of each integer (-1 if it is not in the cache).
+ *      4) Hits, misses and evictions.
+ */
+struct _lru {
+  int n;
+  long budget, used;
+
+  int first, last;
+  int *prev, *next;
+
+  long *size;
+
+  long hits, misses, evictions;
+};
+
+void unlink_L( lru *c , int this );
+void link_first_L( lru *c , int this );
+
+/* Interface function: Initializes an empty cache for the integers 0 to n-1, with the budget
+   given (0 for no budget). */
+lru* new_lru( int n , long budget )
+{
+  lru *c;
+  int i;
+
+  c = (lru*) malloc( sizeof(lru) );
+  mem_check(c);
+
+  c->n = n;
+  c->budget = budget;
+  c->used = 0;
+  c->first = c->last = -1;
+  c->prev = (int*) malloc( (n + 1) * sizeof(int) );
+  c->next = (int*) malloc( (n + 1) * sizeof(int) );
+  c->size = (long*) malloc( (n + 1) * sizeof(long) );
+  mem_check(c->prev);
+  mem_check(c->next);
+  mem_check(c->size);
+
+  for ( i = 0 ; i < n ; i++ ) {
+    c->prev[i] = c->next[i] = -1;
+    c->size[i] = -1;
+  }
+
+  c->hits = c->misses = c->evictions = 0;
+
+  return c;
+}
+
+/* Interface function: Deallocates the cache. */
+void destroy_lru( lru *c )
+{
+  free( c->prev );
+  free( c->next );
+  free( c->size );
+  free( c );
+}
+
+/* Interface function: Changes the budget (0 for none). */
+void set_budget_lru( lru *c , long budget )
+{
+  c->budget = budget;
+}
+
+/* Interface function: Returns the budget (0 for none). */
+long budget_lru( lru *c )
+{
+  return c->budget;
+}
+
+/* Interface function: the integer is used. Returns 1 (a hit) if it is in the cache, and is now
+   the most recently used, or 0 (a miss) if it must be inserted. */
+int use_lru( lru *c , int this )
+{
+  if ( c->size[this] == -1 ) {
+    c->misses++;
+    return 0;
+  }
+
+  c->hits++;
+  unlink_L( c , this );
+  link_first_L( c , this );
+
+  return 1;
+}
+
+/* Interface function: Inserts the integer as the most recently used, with the size given. */
+void insert_lru( lru *c , int this , long size )
+{
+  c->size[this] = size;
+  c->used += size;
+  link_first_L( c , this );
+}
+
+/* Interface function: Removes the integer from the cache, if it is there. */
+void remove_lru( lru *c , int this )
+{
+  if ( c->size[this] == -1 )
+    return;
+
+  unlink_L( c , this );
+  c->used -= c->size[this];
+  c->size[this] = -1;
+}
+
+/* Interface function: Returns the integer to evict so that one of the size given fits in the
+   budget, or -1 if it already fits (or only the most recent one is left). The caller must
+   remove it, and ask again. */
+int victim_lru( lru *c , long size )
+{
+  if ( c->budget == 0 || c->used + size <= c->budget || c->last == c->first )
+    return -1;
+
+  c->evictions++;
+  return c->last;
+}
+
+/* Interface function: Gives the number of hits, misses and evictions. */
+void stats_lru( lru *c , long *hits , long *misses , long *evictions )
+{
+  *hits = c->hits;
+  *misses = c->misses;
+  *evictions = c->evictions;
+}
+
+/* Takes the integer out of the list. */
+void unlink_L( lru *c , int this )
+{
+  if ( c->prev[this] != -1 )
+    c->next[c->prev[this]] = c->next[this];
+  else
+    c->first = c->next[this];
+
+  if ( c->next[this] != -1 )
+    c->prev[c->next[this]] = c->prev[this];
+  else
+    c->last = c->prev[this];
+
+  c->prev[this] = c->next[this] = -1;
+}
+
+/* Puts the integer first in the list. */
+void link_first_L( lru *c , int this )
+{
+  c->prev[this] = -1;
+  c->next[this] = c->first;
+  if ( c->first != -1 )
+    c->prev[c->first] = this;
+  else
+    c->last = this;
+  c->first = this;
+}
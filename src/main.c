@@ -1,18 +1,74 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <signal.h>
 #include "defs.h"
 #include "garage.h"
+#include "workers.h"
+#include "scanner.h"
+#include "events.h"
+
+#define USAGE "Use: ./autopark [--graph=csr|grid] [--trees=full|packed] [--threads=N] [--spt-mem=SIZE] file.cfg file.inp [file.res] \n" \
+              "     (a binary file.inp, from autopark-inp2bin, gives a binary file.ptb) \n" \
+              "     ./autopark [options] --stream[=PIPE] file.cfg [file.res] \n" \
+              "     ./autopark [--graph=csr|grid] [--trees=full|packed] --build-model file.cfg \n"
+
+long parse_size( char *text );
 
 int main( int argc , char **argv )
 {
-  FILE *fpin, *fpin2, *fpin3, *fout2;
+  FILE *fpin2;
+  writer *out;
+  scanner *cfg_in, *res_in;
+  events *cars_in;
   garage* g;
   char extOut[] = ".pts";
-  char *nomeFicheiroIn, *nomeFicheiroOut, *totake;
+  char extBin[] = ".ptb";
+  char extModel[] = ".model";
+  char *nomeFicheiroIn, *nomeFicheiroOut, *nomeModelo, *totake, *extAt;
+  int N, M, P, graph_type = GRAPH_AUTO, tree_type = TREE_AUTO, build_model = 0, stream = 0, res_arg;
+  int failed;
+  long spt_mem = 0, hits, misses, evictions;
+  char *pipe_path = NULL;
+  model_key key;
+  char *data;
+  size_t size;
+
+  /* Options come before the files. */
+  while (argc > 1 && strncmp(argv[1], "--", 2) == 0) {
+    if (strcmp(argv[1], "--graph=csr") == 0) {
+      graph_type = GRAPH_CSR;
+    } else if (strcmp(argv[1], "--graph=grid") == 0) {
+      graph_type = GRAPH_GRID;
+    } else if (strcmp(argv[1], "--trees=full") == 0) {
+      tree_type = TREE_FULL;
+    } else if (strcmp(argv[1], "--trees=packed") == 0) {
+      tree_type = TREE_PACKED;
+    } else if (strncmp(argv[1], "--threads=", 10) == 0) {
+      set_workers(atoi(argv[1] + 10));
+    } else if (strncmp(argv[1], "--spt-mem=", 10) == 0) {
+      spt_mem = parse_size(argv[1] + 10);
+      if (spt_mem <= 0) {
+        fprintf(stderr, "Invalid size %s. " USAGE, argv[1] + 10);
+        exit(0);
+      }
+    } else if (strcmp(argv[1], "--build-model") == 0) {
+      build_model = 1;
+    } else if (strcmp(argv[1], "--stream") == 0) {
+      stream = 1;
+    } else if (strncmp(argv[1], "--stream=", 9) == 0) {
+      stream = 1;
+      pipe_path = argv[1] + 9;
+    } else {
+      fprintf(stderr, "Unknown option %s. " USAGE, argv[1]);
+      exit(0);
+    }
+    argv++;
+    argc--;
+  }
   
-  if (argc < 3) {
-    fprintf(stderr, "Too few arguments. Use: ./autopark file.cfg file.inp [file.res] \n");
+  if (argc < 3 - (build_model || stream)) {
+    fprintf(stderr, "Too few arguments. " USAGE);
     exit(0);
   }
   
@@ -20,39 +76,125 @@ int main( int argc , char **argv )
   nomeFicheiroOut = (char *)malloc((strlen(nomeFicheiroIn)+strlen(extOut)+1)*sizeof(char));
   
   strcpy(nomeFicheiroOut,nomeFicheiroIn);
-  totake = strstr( nomeFicheiroOut , ".cfg");
-  strcpy(totake, extOut);
-  
-  fpin = fopen(argv[1], "r");
-  file_check(fpin, argv[1]);
+  extAt = strstr( nomeFicheiroOut , ".cfg");
+  strcpy(extAt, extOut);
+
+  /* The model of the garage is kept next to its configuration, as file.model. */
+  nomeModelo = (char *)malloc((strlen(nomeFicheiroIn)+strlen(extModel)+1)*sizeof(char));
+  strcpy(nomeModelo,nomeFicheiroIn);
+  totake = strstr( nomeModelo , ".cfg");
+  strcpy(totake, extModel);
   
-  g = read_entryfile(fpin);
+  /* The configuration is hashed before it is read (reading it changes the mapping). */
+  cfg_in = open_scanner(argv[1]);
+  file_check(cfg_in, argv[1]);
+  data = data_scanner(cfg_in, &size);
+  key = hash_data(data, size);
+
+  /* Use the model if it was made from this configuration, else read it (and
+     make the model again, if it was asked or the one there is stale). */
+  g = build_model ? NULL : map_garage(nomeModelo, key, graph_type, tree_type, spt_mem);
+  if (g == NULL) {
+    g = read_entryfile(cfg_in, graph_type, tree_type);
+
+    fpin2 = build_model ? NULL : fopen(nomeModelo, "r");
+    if (build_model || fpin2 != NULL) {
+      if (fpin2 != NULL)
+        fclose(fpin2);
+      if (!save_garage(g, nomeModelo, key))
+        fprintf(stderr, "Could not write model %s. \n", nomeModelo);
+    }
+
+    /* A mapped garage had its budget before its trees were mapped. */
+    set_tree_budget(g, spt_mem);
+  }
   
-  fclose(fpin);
+  close_scanner(cfg_in);
+
+  if (build_model) {
+    free(nomeModelo);
+    free(nomeFicheiroOut);
+    no_restrict(g);
+    destroy_garage(g);
+    exit(0);
+  }
   
-  if (argc > 3){
-    fpin3 = fopen(argv[3], "r");
-    file_check(fpin3, argv[3]);
+  /* A stream has no cars file, the restrictions come right after the configuration. */
+  res_arg = stream ? 2 : 3;
+  if (argc > res_arg){
+    res_in = open_scanner(argv[res_arg]);
+    file_check(res_in, argv[res_arg]);
     
-    read_restrict( g, fpin3 );
-    fclose(fpin3);
+    read_restrict( g, res_in );
+    close_scanner(res_in);
   } else {
     no_restrict(g);
   }
 
-  fpin2 = fopen(argv[2], "r");
-  file_check(fpin2, argv[2]);
-  fout2 = fopen(nomeFicheiroOut, "w");
-  file_check(fout2, nomeFicheiroOut);
+  /* A stream reads the cars from the standard input (or a named pipe) and writes their
+     moves to the standard output, as each one is handled, until its input ends. */
+  if (stream) {
+    cars_in = stream_events(pipe_path);
+    file_check(cars_in, pipe_path == NULL ? "(stdin)" : pipe_path);
+    out = stream_writer(1);
+
+    /* A reader gone is a write error (EPIPE), written and ended as any other. */
+    signal(SIGPIPE, SIG_IGN);
+  } else {
+    cars_in = open_events(argv[2]);
+    file_check(cars_in, argv[2]);
+
+    /* The moves of a binary cars file are written in binary too, as file.ptb. */
+    if (binary_events(cars_in)) {
+      strcpy(extAt, extBin);
+      size_garage(g, &N, &M, &P);
+      out = binary_writer(nomeFicheiroOut, N, M);
+    } else {
+      out = open_writer(nomeFicheiroOut);
+    }
+    file_check(out, nomeFicheiroOut);
+  }
   
-  process_car_file(g, fpin2, fout2);
+  failed = process_car_file(g, cars_in, out) != 0;
 
-  fclose(fout2);
-  fclose(fpin2);
+  if (spt_mem > 0) {
+    tree_stats(g, &hits, &misses, &evictions);
+    fprintf(stderr, "Trees: %ld hits, %ld misses, %ld evictions. \n", hits, misses, evictions);
+  }
+
+  /* The error was written by the writer, only the exit status is left. */
+  failed = close_writer(out) != 0 || failed;
 	
   free(nomeFicheiroOut);
+  free(nomeModelo);
   destroy_garage(g);
 
-  exit(0);
+  /* The tags of the cars are in its mapping (if not a stream), so it is the last to go. */
+  close_events(cars_in);
+
+  exit(failed ? 1 : 0);
 }
 
+/* Reads a size in bytes, with an optional K, M or G suffix. Returns -1 if it is not valid. */
+long parse_size( char *text )
+{
+  char *end;
+  long size;
+
+  size = strtol(text, &end, 10);
+  if (end == text)
+    return -1;
+
+  if (*end == 'K' || *end == 'k') {
+    size <<= 10;
+    end++;
+  } else if (*end == 'M' || *end == 'm') {
+    size <<= 20;
+    end++;
+  } else if (*end == 'G' || *end == 'g') {
+    size <<= 30;
+    end++;
+  }
+
+  return *end == '\0' ? size : -1;
+}
@@ -0,0 +1,224 @@
+/*
+ *  File name: model.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Binary files with a garage already read and searched (its
+ *               model), loaded by mapping them in memory.
+ *
+ *  Implementation details:
+ *    Each section is written as its size followed by its data, padded to a
+ *    multiple of 8 bytes, so the arrays in the mapping are aligned. A section
+ *    read must have the size expected, otherwise the file is not trusted.
+ *
+ *    A model is written to a temporary file, that only replaces the old one
+ *    when it is complete: a program mapping the old file keeps its pages.
+ *
+ *    The pages of a section no longer used (a tree evicted from the cache)
+ *    are given back with madvise, as the pages changed in a private mapping
+ *    are memory of the program, and the others stay in its resident set.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "defs.h"
+#include "model.h"
+
+#define MODEL_MAGIC "AUTOPARK"
+#define MODEL_VERSION 4
+
+/* Sections are aligned to this number of bytes. */
+#define MODEL_ALIGN 8
+
+/*
+ *  Data Type: model_header (private)
+ *  Description: Structure with:
+ *      1) Magic bytes and format version.
+ *      2) Key of the configuration file the model was made from.
+ */
+typedef struct _model_header {
+  char magic[8];
+  long version;
+  model_key key;
+} model_header;
+
+/*
+ *  Data Type: model
+ *  Description: Structure with:
+ *      1) Mapped file and its size.
+ *      2) Position of the next section.
+ */
+struct _model {
+  char *base;
+  size_t size;
+  size_t pos;
+};
+
+char* temp_path( char *path );
+
+/* Interface function: hash of the contents of a file (size bytes). */
+model_key hash_data( char *data , size_t size )
+{
+  model_key key;
+
+  key.hash = fnv1a( data , size , FNV_OFFSET );
+  key.size = (long) size;
+
+  return key;
+}
+
+/* Interface function: maps the model in the path given. Returns NULL if there is none, or if it
+   was not made from the configuration file with the key given, or by this version. */
+model* open_model( char *path , model_key key )
+{
+  model *m;
+  model_header *h;
+  struct stat st;
+  void *base;
+  int fd;
+
+  fd = open( path , O_RDONLY );
+  if ( fd < 0 )
+    return NULL;
+
+  if ( fstat( fd , &st ) != 0 || st.st_size < (off_t) sizeof(model_header) ) {
+    close( fd );
+    return NULL;
+  }
+
+  base = mmap( NULL , st.st_size , PROT_READ | PROT_WRITE , MAP_PRIVATE , fd , 0 );
+  close( fd );
+  if ( base == MAP_FAILED )
+    return NULL;
+
+  h = (model_header*) base;
+  if ( memcmp( h->magic , MODEL_MAGIC , 8 ) != 0 || h->version != MODEL_VERSION ||
+       h->key.hash != key.hash || h->key.size != key.size ) {
+    munmap( base , st.st_size );
+    return NULL;
+  }
+
+  m = (model*) malloc( sizeof(model) );
+  mem_check(m);
+
+  m->base = (char*) base;
+  m->size = st.st_size;
+  m->pos = sizeof(model_header);
+
+  return m;
+}
+
+/* Interface function: returns the next section, which must have the size given (NULL if not). */
+void* read_model( model *m , size_t size )
+{
+  size_t stored;
+  void *data;
+
+  if ( m->pos + sizeof(size_t) > m->size )
+    return NULL;
+
+  memcpy( &stored , m->base + m->pos , sizeof(size_t) );
+  if ( stored != size || m->pos + MODEL_ALIGN + size > m->size )
+    return NULL;
+
+  data = m->base + m->pos + MODEL_ALIGN;
+  m->pos += MODEL_ALIGN + (size + MODEL_ALIGN - 1) / MODEL_ALIGN * MODEL_ALIGN;
+
+  return data;
+}
+
+/* Interface function: gives back the memory of a section read (size bytes at data), which
+   must not be used again. Only the pages wholly inside it are given back. */
+void release_model( void *data , size_t size )
+{
+  size_t page = (size_t) sysconf( _SC_PAGESIZE );
+  size_t start = ((size_t) data + page - 1) / page * page;
+  size_t end = ((size_t) data + size) / page * page;
+
+  if ( end > start )
+    madvise( (void*) start , end - start , MADV_DONTNEED );
+}
+
+/* Interface function: unmaps the model. The sections read are no longer valid. */
+void destroy_model( model *m )
+{
+  munmap( m->base , m->size );
+  free( m );
+}
+
+/* Interface function: starts writing a model of the configuration file with the key given.
+   Returns NULL if the file can not be created. */
+FILE* create_model( char *path , model_key key )
+{
+  model_header h;
+  char *temp;
+  FILE *fp;
+
+  temp = temp_path( path );
+  fp = fopen( temp , "wb" );
+  free( temp );
+  if ( fp == NULL )
+    return NULL;
+
+  memset( &h , 0 , sizeof(h) );
+  memcpy( h.magic , MODEL_MAGIC , 8 );
+  h.version = MODEL_VERSION;
+  h.key = key;
+  fwrite( &h , sizeof(h) , 1 , fp );
+
+  return fp;
+}
+
+/* Interface function: writes the next section of the model. */
+void write_model( FILE *fp , void *data , size_t size )
+{
+  char pad[MODEL_ALIGN];
+
+  memset( pad , 0 , MODEL_ALIGN );
+
+  fwrite( &size , sizeof(size_t) , 1 , fp );
+  fwrite( pad , 1 , MODEL_ALIGN - sizeof(size_t) , fp );
+  if ( size > 0 )
+    fwrite( data , 1 , size , fp );
+  fwrite( pad , 1 , (MODEL_ALIGN - size % MODEL_ALIGN) % MODEL_ALIGN , fp );
+}
+
+/* Interface function: ends the model, which replaces the one in the path given.
+   Returns 0 if it could not be written. */
+int close_model( FILE *fp , char *path )
+{
+  char *temp;
+  int ok;
+
+  temp = temp_path( path );
+  ok = ( ferror( fp ) == 0 );
+  ok = ( fclose( fp ) == 0 ) && ok;
+  ok = ok && ( rename( temp , path ) == 0 );
+  if ( !ok )
+    remove( temp );
+  free( temp );
+
+  return ok;
+}
+
+/* Name of the file where the model is written before it is complete. */
+char* temp_path( char *path )
+{
+  char *temp;
+
+  temp = (char*) malloc( (strlen(path) + 5) * sizeof(char) );
+  mem_check(temp);
+  strcpy( temp , path );
+  strcat( temp , ".tmp" );
+
+  return temp;
+}
@@ -3,84 +3,200 @@
  *
  *  Authors: Miguel Malaca & Miguel Pinho
  *
- *  Description: C-Implementation of a queue (FIFO)
+ *  Description: C-Implementation of a queue (FIFO), where an element can
+ *      also be removed from the middle, by the entry it was given.
  *
  *  Implementation details:
- *    The queue is implemented using a LinkedList, and pointer to the start and
- *    end of it. Insertion is done in the end and removal in the beginning.
+ *    The queue is implemented using a ring buffer, a power of two in size,
+ *    that doubles when full. Each element gets a number, one more than the
+ *    last one inserted, and is kept in the slot given by that number (modulo
+ *    the size). The elements are numbered again when the buffer grows.
+ *
+ *    The entries are not moved (only their slots are), so an entry is the
+ *    handle of its element. An element removed by its entry leaves an empty
+ *    slot (a tombstone), skipped when it reaches the start. If the tombstones
+ *    are at least half the buffer, it is compacted, instead of doubled.
  *
  */
 
 #include <stdlib.h>
 #include <stdio.h>
 #include "queue.h"
+#include "slab.h"
+
+/*
+ *  Data Type: q_entry (semi-private)
+ *  Description: Structure with:
+ *      1) Element.
+ *      2) Number of the element (its slot, modulo the size).
+ */
+struct _q_entry {
+  Item this;
+  long number;
+};
 
+/*
+ *  Data Type: queue (semi-private)
+ *  Description: Structure with:
+ *      1) Slots (NULL if empty), and their number (a power of two).
+ *      2) Numbers of the first element and of the next to be inserted.
+ *      3) Number of elements (without the tombstones).
+ *      4) Slab of the entries.
+ */
 struct _queue {
-  LinkedList *start, *end;
+  q_entry **slots;
+  long size;
+  long start, end;
+  int n_elements;
+  slab *entries;
 };
 
+void skip_queue( queue *q );
+void grow_queue( queue *q );
 
-queue *new_queue( )
+/* Interface function: Initializes an empty queue. */
+queue *new_queue( void )
 {
   queue *new;
 
   new = malloc(sizeof(queue));
   mem_check(new);
 
-  new->start = initLinkedList();
-  new->end = new->start;
+  new->size = 16;
+  new->slots = (q_entry**) calloc( new->size , sizeof(q_entry*) );
+  mem_check(new->slots);
+  new->start = new->end = 0;
+  new->n_elements = 0;
+
+  new->entries = new_slab( sizeof(q_entry) );
 
   return new;
 }
 
 void destroy_queue( queue *q , void (*freeItemFnt)(Item) )
 {
-  freeLinkedList( q->start , freeItemFnt );
+  clear_queue( q , freeItemFnt );
+
+  destroy_slab( q->entries );
+  free(q->slots);
 
   free(q);
 }
+
 void clear_queue( queue *q , void (*freeItemFnt)(Item) )
 {
-  freeLinkedList( q->start , freeItemFnt );
+  q_entry *e;
+
+  for ( ; q->start < q->end ; q->start++ ) {
+    e = q->slots[q->start & (q->size - 1)];
+    if ( e != NULL && freeItemFnt != NULL )
+      freeItemFnt( e->this );
+    q->slots[q->start & (q->size - 1)] = NULL;
+  }
 
-  q->start = initLinkedList();
-  q->end = q->start;
+  clear_slab( q->entries );
+
+  q->start = q->end = 0;
+  q->n_elements = 0;
 }
-  
+
 int isEmpty_queue( queue *q )
 {
-  return ( q->start == NULL );
+  return ( q->n_elements == 0 );
 }
 
-void insert_queue( queue *q , Item this )
+/* Interface function: Inserts an element at the end. Returns its entry, which can remove
+   it while it is in the queue. */
+q_entry *insert_queue( queue *q , Item this )
 {
-  if ( q->start == NULL ) {
-    q->start = insertUnsortedLinkedList( q->start , this );
-    q->end = q->start;
-  } else {
-    insertAfterLinkedList( q->end , this );
-    q->end = getNextNodeLinkedList( q->end );
-  }
+  q_entry *e;
+
+  if ( q->end - q->start == q->size )
+    grow_queue( q );
+
+  e = (q_entry*) alloc_slab( q->entries );
+  e->this = this;
+  e->number = q->end++;
+
+  q->slots[e->number & (q->size - 1)] = e;
+  q->n_elements++;
+
+  return e;
 }
 
 Item remove_queue( queue *q )
+{
+  q_entry *e;
+  Item this;
+
+  if ( q->n_elements == 0 ) return NULL;
+
+  e = q->slots[q->start & (q->size - 1)];
+  q->slots[q->start & (q->size - 1)] = NULL;
+  q->start++;
+  q->n_elements--;
+  skip_queue( q );
+
+  this = e->this;
+  free_slab( q->entries , e );
+
+  return this;
+}
+
+/* Interface function: Removes and returns the element of the entry given (by insert_queue),
+   wherever it is in the queue. The entry must still be in the queue. */
+Item remove_entry_queue( queue *q , q_entry *e )
 {
   Item this;
-  
-  if ( q->start == NULL ) return NULL;
 
-  this = getItemLinkedList( q->start );
-  q->start = removeHeadLinkedList( q->start );
+  /* Leaves a tombstone (skipped at once, if it was the first element). */
+  q->slots[e->number & (q->size - 1)] = NULL;
+  q->n_elements--;
+  skip_queue( q );
 
-  /* Perhaps not necessary: */
-  if ( q->start == NULL ) q->end = NULL;
+  this = e->this;
+  free_slab( q->entries , e );
 
   return this;
 }
 
 Item peek_queue( queue *q )
 {
-  if ( q-> start == NULL ) return NULL;
+  if ( q->n_elements == 0 ) return NULL;
+
+  return q->slots[q->start & (q->size - 1)]->this;
+}
+
+/* Private. Moves the start past the tombstones. */
+void skip_queue( queue *q )
+{
+  while ( q->start < q->end && q->slots[q->start & (q->size - 1)] == NULL )
+    q->start++;
+
+  if ( q->start == q->end )
+    q->start = q->end = 0;
+}
+
+/* Private. Makes room for one more element: if at least half the slots are tombstones,
+   the elements are moved to the start, otherwise the slots are doubled. */
+void grow_queue( queue *q )
+{
+  q_entry **old = q->slots;
+  long i, old_size = q->size, start = q->start, end = q->end;
+
+  if ( 2 * q->n_elements > old_size )
+    q->size *= 2;
+  q->slots = (q_entry**) calloc( q->size , sizeof(q_entry*) );
+  mem_check(q->slots);
+
+  /* The elements are numbered again from 0, in order. */
+  q->start = q->end = 0;
+  for ( i = start ; i < end ; i++ ) {
+    if ( old[i & (old_size - 1)] != NULL ) {
+      old[i & (old_size - 1)]->number = q->end;
+      q->slots[q->end++] = old[i & (old_size - 1)];
+    }
+  }
 
-  return getItemLinkedList( q->start );
+  free(old);
 }
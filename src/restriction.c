@@ -8,84 +8,108 @@
  *    and applies them to the garage variables.
  *
  *  Implementation details:
- *    A group of LinkedLists was used for each type of restriction, has they
- *    they have different effects on the garage. Each restriction is represented
- *    by a start intant, an end instant and a value (its interpertation depends
- *    on the type, defined by where it is stored).
+ *    Each restriction is read as two events: at its start instant one more
+ *    restriction is on its target (a floor or a position), and at its end
+ *    instant one less. The events of all restrictions are sorted once by
+ *    instant, in a single timeline, and updating the restrictions to a new
+ *    instant just goes through the events up to it, counting the ones on
+ *    each target. A target is restricted while its count is not 0, so a
+ *    restriction that starts and ends between two updates is never seen.
+ *
+ *    The positions whose restriction changed in the last update are kept, so
+ *    only their flags are changed when it is applied.
  *
  */
 
 #include <stdlib.h>
 #include <stdio.h>
 #include "restriction.h"
+#include "containers.h"
+
+/* Targets of the events. */
+#define ON_FLOOR 0
+#define ON_POS 1
 
 /*
- *  Data Type: restrict_data (semi-private)
+ *  Data Type: event (private)
  *  Description: Structure with:
- *      1,2) Instants when any resriction changes, either starting or ending. 
- *           They are the only ordered lists.
- *      3,4) Restrictions not yet active.
- *      5,6) Active and applieable restrictions.
+ *      1) Instant.
+ *      2) Type of target (floor or position), and its number.
+ *      3) Change in the number of restrictions on the target (+1 or -1, or 0
+ *         for a restriction that ends before it starts).
  */
-struct _restrict_data {
-  LinkedList *instants_r_floor, *instants_r_pos;
-  LinkedList *on_hold_r_floor, *on_hold_r_pos;
-  LinkedList *active_r_floor, *active_r_pos;
-};
+typedef struct _event {
+  int t;
+  int on, target;
+  int delta;
+} event;
+
+DEFINE_VEC(event_vec, event)
+DEFINE_VEC(int_vec, int)
 
 /*
- *  Data Type: restriction (private)
+ *  Data Type: restrict_data (semi-private)
  *  Description: Structure with:
- *      1) Start instant.
- *      2) End instant.
- *      3) Value, can represent the floor or the position number.
+ *      1) Timeline of events, sorted by instant, and the next one to happen.
+ *      2) Number of restrictions on each floor and on each position.
+ *      3) Positions whose restriction changed in the last update, and the
+ *         state of each one before it (0 if not in the list, 1 if it was
+ *         free, 2 if it was restricted).
  */
-typedef struct _restriction {
-  int start, end, value;
-} restriction;
-
-/* Macro used to verify if an change instant has passed. */
-#define t_passed(next_t, t) ((next_t) != NULL && (t) >= *(next_t))
+struct _restrict_data {
+  event_vec events;
+  int next;
+  int *on_floor, *on_pos;
+  int n_floors, n_pos;
+  int_vec changed;
+  char *before;
+};
 
-restriction *new_rest( int start , int end , int value );
-int is_restricted( restriction *r , int t );
-void change_restrict_list( LinkedList **on_hold_r , LinkedList **active_r , int t );
+int cmp_event( const void *a , const void *b );
+int cmp_pos( const void *a , const void *b );
+void add_restrict( event_vec *events , int on , int target , int start , int end );
 
-/* Reads restrictions from the respective file pointer. */
-restrict_data *init_restrict( FILE *restrict_fp , int M , int N )
+/* Reads restrictions from the respective file, for a garage of P floors of M by N. */
+restrict_data *init_restrict( scanner *restrict_in , int M , int N , int P )
 {
   restrict_data *r_data;
-  char buffer[LINE_SIZE];
-  int ta, tb, px, ex, ey, ez;
+  char r;
+  int v[5], n;
 
   r_data = (restrict_data*) malloc(sizeof(restrict_data));
   mem_check(r_data);
-  
-  r_data->instants_r_floor = initLinkedList();
-  r_data->instants_r_pos = initLinkedList();
-  r_data->on_hold_r_floor = initLinkedList();
-  r_data->on_hold_r_pos = initLinkedList();
-  r_data->active_r_floor = initLinkedList();
-  r_data->active_r_pos = initLinkedList();
-
-  while ( fgets( buffer , LINE_SIZE , restrict_fp ) != NULL ) {
-    if ( sscanf( buffer , "R %d %d %d %d %d" , &ta , &tb , &ex , &ey , &ez ) == 5 ) {
-      r_data->on_hold_r_pos = insertUnsortedLinkedList( r_data->on_hold_r_pos , (Item) new_rest( ta , tb , get_index(ex, ey, ez, M, N) ) );
-
-      if (tb != 0)
-	r_data->instants_r_pos = insertSortedLinkedList( r_data->instants_r_pos , (Item) new_int( tb ) , cmp_int , free );
-      
-      r_data->instants_r_pos = insertSortedLinkedList( r_data->instants_r_pos , (Item) new_int( ta ) , cmp_int , free );
-    } else if ( sscanf( buffer , "R %d %d %d" , &ta , &tb , &px ) == 3 ) {
-      r_data->on_hold_r_floor = insertUnsortedLinkedList( r_data->on_hold_r_floor , (Item) new_rest( ta , tb , px ) );
-
-      if (tb != 0)
-	r_data->instants_r_floor = insertSortedLinkedList( r_data->instants_r_floor , (Item) new_int( tb ) , cmp_int , free );
-      
-      r_data->instants_r_floor = insertSortedLinkedList( r_data->instants_r_floor , (Item) new_int( ta ) , cmp_int , free );
+
+  r_data->n_floors = P;
+  r_data->n_pos = M * N * P;
+  r_data->on_floor = (int*) calloc( r_data->n_floors , sizeof(int) );
+  r_data->on_pos = (int*) calloc( r_data->n_pos , sizeof(int) );
+  r_data->before = (char*) calloc( r_data->n_pos , sizeof(char) );
+  mem_check(r_data->on_floor);
+  mem_check(r_data->on_pos);
+  mem_check(r_data->before);
+  int_vec_init( &(r_data->changed) );
+
+  event_vec_init( &(r_data->events) );
+  r_data->next = 0;
+
+  /* Lines "R ta tb x y z" restrict a position, and "R ta tb p" a floor. */
+  while ( next_line( restrict_in ) ) {
+    if ( !scan_char( restrict_in , &r ) || r != 'R' )
+      continue;
+    for ( n = 0 ; n < 5 && scan_int( restrict_in , &v[n] ) ; n++ );
+
+    if ( n == 5 ) {
+      if ( v[2] >= 0 && v[2] < N && v[3] >= 0 && v[3] < M && v[4] >= 0 && v[4] < P )
+	add_restrict( &(r_data->events) , ON_POS , get_index(v[2], v[3], v[4], M, N) , v[0] , v[1] );
+    } else if ( n >= 3 ) {
+      if ( v[2] >= 0 && v[2] < P )
+	add_restrict( &(r_data->events) , ON_FLOOR , v[2] , v[0] , v[1] );
     }
   }
 
+  if ( r_data->events.n > 1 )
+    qsort( r_data->events.data , r_data->events.n , sizeof(event) , cmp_event );
+
   return r_data;
 }
 
@@ -93,85 +117,75 @@ restrict_data *init_restrict( FILE *restrict_fp , int M , int N )
 /* Return value: res = 0 -> no restrictions changes , res = 1 -> only floor_r changed , res = 2 -> pos_r changed */
 int update_restrict( restrict_data *r_data , int *t , int new_t )
 {
-  int res = 0;
-  int *next_t_floor, *next_t_pos;
-
-  next_t_floor = (int*) getItemLinkedList(r_data->instants_r_floor);
-  next_t_pos = (int*) getItemLinkedList(r_data->instants_r_pos);
-  
-  if ( t_passed(next_t_floor, new_t) ) {
-    /* A floor restriction started or ended. */
-    res = 1;
-
-    /* Advance the instants of changes for floors. */
-    while ( t_passed(next_t_floor, new_t) ) {
-      r_data->instants_r_floor = freeHeadLinkedList( r_data->instants_r_floor , free );
-      next_t_floor = (int*) getItemLinkedList(r_data->instants_r_floor);
-    }
+  event *e;
+  int res = 0, i, n, v;
 
-    /* Update floor restrictions list. */
-    change_restrict_list( &(r_data->on_hold_r_floor) , &(r_data->active_r_floor) , new_t );
-  }
+  r_data->changed.n = 0;
 
-  if ( t_passed(next_t_pos, new_t) ) {
-    /* A pos restriction started or ended. */
-    res = 2;
+  /* Goes through the events up to the new instant. */
+  for ( ; r_data->next < r_data->events.n && r_data->events.data[r_data->next].t <= new_t ; r_data->next++ ) {
+    e = &(r_data->events.data[r_data->next]);
 
-    /* Advance the instants of changes for pos. */
-    while ( t_passed(next_t_pos, new_t) ) {
-      r_data->instants_r_pos = freeHeadLinkedList( r_data->instants_r_pos , free );
-      next_t_pos = (int*) getItemLinkedList(r_data->instants_r_pos);
+    if ( e->on == ON_FLOOR ) {
+      /* A floor restriction started or ended. */
+      if ( res == 0 )
+	res = 1;
+      r_data->on_floor[e->target] += e->delta;
+    } else {
+      /* A pos restriction started or ended. */
+      res = 2;
+      if ( r_data->before[e->target] == 0 ) {
+	r_data->before[e->target] = 1 + ( r_data->on_pos[e->target] != 0 );
+	int_vec_push( &(r_data->changed) , e->target );
+      }
+      r_data->on_pos[e->target] += e->delta;
     }
+  }
 
-    /* Update pos restrictions lists. */
-    change_restrict_list( &(r_data->on_hold_r_pos) , &(r_data->active_r_pos) , new_t );
+  /* Keeps only the positions that did change, in order. */
+  for ( i = n = 0 ; i < r_data->changed.n ; i++ ) {
+    v = r_data->changed.data[i];
+    if ( r_data->before[v] != 1 + ( r_data->on_pos[v] != 0 ) )
+      r_data->changed.data[n++] = v;
+    r_data->before[v] = 0;
   }
-  
+  r_data->changed.n = n;
+  if ( n > 1 )
+    qsort( r_data->changed.data , n , sizeof(int) , cmp_pos );
+
   *t = new_t;
   return res;
 }
 
-/* Applies both the active restrictions, floor and position. */
-void apply_restrict_complete( restrict_data *r_data , int *info , int size_info , int *floor_flags , int size_ff )
+/* Applies both the active restrictions, floor and position. Only the positions changed by the
+   last update are written in info, and they are returned, in order (n_changed of them). */
+int *apply_restrict_complete( restrict_data *r_data , int *info , int size_info , int *floor_flags , int size_ff ,
+			      int *n_changed )
 {
-  LinkedList *aux;
-  restriction *r;
-  int i;
-
-  /* Resets all restriction flags. */
-  for ( i = 0 ; i < size_info ; i++ ) reset_flag(info[i]);
-  for ( i = 0 ; i < size_ff ; i++ ) floor_flags[i] = 0;
+  int i, v;
 
-  /* Applies floor restrictions. */
-  for ( aux = r_data->active_r_floor ; aux != NULL ; aux = getNextNodeLinkedList(aux) ) {
-    r = getItemLinkedList(aux);
-
-    floor_flags[r->value] = 1;
-  }
+  apply_restrict_parcial( r_data , floor_flags , size_ff );
 
   /* Applies pos restrictions. */
-  for ( aux = r_data->active_r_pos ; aux != NULL ; aux = getNextNodeLinkedList(aux) ) {
-    r = getItemLinkedList(aux);
-
-    set_flag(info[r->value]);
+  for ( i = 0 ; i < r_data->changed.n ; i++ ) {
+    v = r_data->changed.data[i];
+    if ( r_data->on_pos[v] != 0 )
+      set_flag(info[v]);
+    else
+      reset_flag(info[v]);
   }
+
+  *n_changed = r_data->changed.n;
+  return r_data->changed.data;
 }
 
 /* Applies only the active floor restrictions. */
 void apply_restrict_parcial( restrict_data *r_data , int *floor_flags , int size_ff )
 {
-  LinkedList *aux;
-  restriction *r;
   int i;
 
-  /* Resets floor flags. */
-  for ( i = 0 ; i < size_ff ; i++ ) floor_flags[i] = 0;
-
-  /* Applies floor restrictions. */
-  for ( aux = r_data->active_r_floor ; aux != NULL ; aux = getNextNodeLinkedList(aux) ) {
-    r = getItemLinkedList(aux);
-
-    floor_flags[r->value] = 1;
+  for ( i = 0 ; i < size_ff ; i++ ) {
+    floor_flags[i] = ( i < r_data->n_floors && r_data->on_floor[i] != 0 );
   }
 }
 
@@ -182,98 +196,46 @@ void destroy_restrict( restrict_data *r_data )
   if ( r_data == NULL )
     return;
 
-  /* Free all lists. */
-  freeLinkedList(r_data->instants_r_floor, free);
-  freeLinkedList(r_data->instants_r_pos, free);
-  freeLinkedList(r_data->on_hold_r_floor, free);
-  freeLinkedList(r_data->on_hold_r_pos, free);
-  freeLinkedList(r_data->active_r_floor, free);
-  freeLinkedList(r_data->active_r_pos, free);
+  event_vec_free( &(r_data->events) );
+  int_vec_free( &(r_data->changed) );
+  free(r_data->on_floor);
+  free(r_data->on_pos);
+  free(r_data->before);
 
   /* Can now free r_data. */
   free(r_data);
 }
 
-/* Private. Allocates and initializes a new restriction. */
-restriction *new_rest( int start , int end , int value )
+/* Private. Adds the events of a restriction, from start to end (0 if it does not end). */
+void add_restrict( event_vec *events , int on , int target , int start , int end )
 {
-  restriction *new;
-
-  new = malloc(sizeof(restriction));
-  mem_check(new);
-  
-  new->start = start;
-  new->end = end;
-  new->value = value;
-  
-  return new;
-}
+  event e;
 
-/* Private. Check a restriction. */
-/* return value: -1 -> to happen ; 0 -> in effect ; 1 -> has ended */
-int is_restricted( restriction *r , int t )
-{
-  if ( t < r->start ) return -1;
+  e.on = on;
+  e.target = target;
 
-  if ( r->end != 0 && t >= r->end ) return 1;
+  /* One that ends before it starts is never in effect, but its instants are still changes. */
+  e.t = start;
+  e.delta = ( end == 0 || end > start ) ? 1 : 0;
+  event_vec_push( events , e );
 
-  return 0;
+  if ( end != 0 ) {
+    e.t = end;
+    e.delta = -e.delta;
+    event_vec_push( events , e );
+  }
 }
 
-/* Private. Processes and updates both the active and on_hold restriction lists. */
-void change_restrict_list( LinkedList **on_hold_r , LinkedList **active_r , int t )
+/* Private. Orders the events by instant. */
+int cmp_event( const void *a , const void *b )
 {
-  LinkedList *aux, *aux2;
-  restriction *r;
-  int res;
-  
-  /* Clear restrictions that ended. */
-  aux = *active_r;
-  aux2 = NULL;
-  while ( aux != NULL ) {
-    r = (restriction*) getItemLinkedList(aux);
-    
-    if ( is_restricted( r , t ) == 1 ) {
-      free(r);
-      
-      if ( aux2 == NULL ) {
-	*active_r = aux = removeHeadLinkedList(aux);
-      } else {
-	removeMiddleLinkedList(aux2);
-	aux = getNextNodeLinkedList(aux2);
-      }
-    } else {
-      aux2 = aux;
-      aux = getNextNodeLinkedList(aux);
-    }
-  }
+  int ta = ((const event*) a)->t, tb = ((const event*) b)->t;
 
-  /* Pass to active restrictions the ones that started and clear the ones that were "jumped". */
-  aux = *on_hold_r;
-  aux2 = NULL;
-  while ( aux != NULL ) {
-    r = (restriction*) getItemLinkedList(aux);
-    
-    if ( (res = is_restricted( r , t )) != -1 ) {
-      /* Remove from the list the on_hold list. */
-      if ( aux2 == NULL ) {
-	*on_hold_r = aux = removeHeadLinkedList(aux);
-      } else {
-	removeMiddleLinkedList(aux2);
-	aux = getNextNodeLinkedList(aux2);
-      }
-      
-      if ( res == 0 ) {
-	/* Pass to active. */
-	*active_r = insertUnsortedLinkedList( *active_r , (Item) r );
-      } else {
-	/* "Jumped" -> delete. */
-	free(r);
-      }
-    } else {
-      aux2 = aux;
-      aux = getNextNodeLinkedList(aux);
-    }
-  }
+  return ( ta > tb ) - ( ta < tb );
 }
 
+/* Private. Orders positions. */
+int cmp_pos( const void *a , const void *b )
+{
+  return *((const int*) a) - *((const int*) b);
+}
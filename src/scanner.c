@@ -0,0 +1,317 @@
+/*
+ *  File name: scanner.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Reading of the text files (configuration, cars and
+ *      restrictions) mapped in memory, a line at a time, with scanners for
+ *      the tokens, integers and characters of each line.
+ *
+ *  Implementation details:
+ *    The end of each line is found once, when it is started, so the tokens
+ *    can be ended by writing over the blank after them (even the newline).
+ *    For that the file must end in a newline: one that does not gets it in
+ *    the rest of its last page (mapped, but not in the file), and one that
+ *    fills its last page, or that cannot be mapped (a pipe), is read into
+ *    memory instead, with one added.
+ *
+ *    A stream is read in a buffer, as the lines come: a line is only started
+ *    when all of it was read (or the stream ended). The lines read are moved
+ *    to the start of the buffer when it has no whole line left, so the
+ *    buffer only grows to fit the longest line. A named pipe is opened again
+ *    when its writers close it, waiting for the next one.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "scanner.h"
+
+/* Size of the buffer of a stream, at the start. */
+#define STREAM_BUFFER 65536
+
+#define is_blank(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\v' || (c) == '\f')
+
+/*
+ *  Data Type: scanner (semi-private)
+ *  Description: Structure with:
+ *      1) File contents (mapped or read), its size, and its end (after the
+ *         newline added, if it was read).
+ *      2) Position in the current line, its end (the newline), and the start
+ *         of the next line.
+ *      3) For a stream: its descriptor, the size of the buffer, and the path
+ *         of the named pipe (NULL for the standard input).
+ */
+struct _scanner {
+  char *base;
+  size_t size;
+  char *end;
+  int mapped;
+  char *pos, *eol, *next;
+  int fd;
+  size_t max;
+  char *path;
+};
+
+char* read_whole( int fd , size_t *size );
+int read_stream( scanner *s );
+
+/* Interface function: maps the file in the path given. Returns NULL if it cannot be opened. */
+scanner* open_scanner( char *path )
+{
+  scanner *s;
+  struct stat st;
+  void *base = MAP_FAILED;
+  int fd;
+
+  fd = open( path , O_RDONLY );
+  if ( fd < 0 )
+    return NULL;
+
+  s = (scanner*) malloc( sizeof(scanner) );
+  mem_check(s);
+
+  if ( fstat( fd , &st ) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 ) {
+    base = mmap( NULL , st.st_size , PROT_READ | PROT_WRITE , MAP_PRIVATE , fd , 0 );
+    if ( base != MAP_FAILED && ((char*) base)[st.st_size - 1] != '\n'
+	 && st.st_size % sysconf( _SC_PAGESIZE ) == 0 ) {
+      munmap( base , st.st_size );
+      base = MAP_FAILED;
+    }
+  }
+
+  if ( base != MAP_FAILED ) {
+    s->base = (char*) base;
+    s->size = st.st_size;
+    s->end = s->base + s->size;
+    if ( s->end[-1] != '\n' )
+      *(s->end++) = '\n';
+    s->mapped = 1;
+  } else {
+    s->base = read_whole( fd , &(s->size) );
+    s->end = s->base + s->size;
+    if ( s->size > 0 && s->end[-1] != '\n' )
+      *(s->end++) = '\n';
+    s->mapped = 0;
+  }
+  close( fd );
+
+  s->pos = s->eol = s->next = s->base;
+  s->fd = -1;
+  s->path = NULL;
+  return s;
+}
+
+/* Interface function: reads the named pipe in the path given (or the standard input, if it
+   is NULL) as its lines come. Returns NULL if it cannot be opened. */
+scanner* stream_scanner( char *path )
+{
+  scanner *s;
+  int fd = 0;
+
+  if ( path != NULL && (fd = open( path , O_RDONLY )) < 0 )
+    return NULL;
+
+  s = (scanner*) malloc( sizeof(scanner) );
+  mem_check(s);
+
+  s->max = STREAM_BUFFER;
+  s->base = (char*) malloc( s->max );
+  mem_check(s->base);
+  s->size = 0;
+  s->end = s->pos = s->eol = s->next = s->base;
+  s->mapped = 0;
+  s->fd = fd;
+  s->path = path;
+
+  return s;
+}
+
+/* Interface function: returns 1 if the tokens last until the scanner is closed, or 0 if
+   they only last until the next line (a stream). */
+int tokens_last( scanner *s )
+{
+  return s->fd == -1 && s->path == NULL;
+}
+
+/* Interface function: unmaps the file. The tokens given are no longer valid. */
+void close_scanner( scanner *s )
+{
+  if ( s->mapped )
+    munmap( s->base , s->size );
+  else
+    free( s->base );
+  if ( s->path != NULL )
+    close( s->fd );
+
+  free( s );
+}
+
+/* Interface function: returns the contents of the file, as they are in it (size bytes). */
+char* data_scanner( scanner *s , size_t *size )
+{
+  *size = s->size;
+  return s->base;
+}
+
+/* Interface function: starts the next line. Returns 0 at the end of the file (for a stream,
+   waits for the line, and returns 0 when the standard input ends). */
+int next_line( scanner *s )
+{
+  if ( s->fd != -1 && !read_stream( s ) )
+    return 0;
+
+  if ( s->next >= s->end )
+    return 0;
+
+  s->pos = s->next;
+  s->eol = (char*) memchr( s->pos , '\n' , s->end - s->pos );
+  s->next = s->eol + 1;
+
+  return 1;
+}
+
+/* Interface function: returns the rest of the line, as it is, with its length (without the
+   newline, which is not replaced). */
+char* scan_line( scanner *s , int *len )
+{
+  char *start = s->pos;
+
+  *len = (int) (s->eol - start);
+  s->pos = s->eol;
+
+  return start;
+}
+
+/* Interface function: returns the next token of the line (NULL if there is none), ended
+   by a '\0' in the place of the blank after it. */
+char* scan_token( scanner *s )
+{
+  char *start;
+
+  while ( s->pos < s->eol && is_blank(*(s->pos)) )
+    s->pos++;
+  if ( s->pos == s->eol )
+    return NULL;
+
+  start = s->pos;
+  while ( s->pos < s->eol && !is_blank(*(s->pos)) )
+    s->pos++;
+
+  *(s->pos) = '\0';
+  if ( s->pos < s->eol )
+    s->pos++;
+
+  return start;
+}
+
+/* Interface function: reads the next integer of the line (with an optional sign) into x.
+   Returns 0 if there is none. */
+int scan_int( scanner *s , int *x )
+{
+  char *p;
+  unsigned long value = 0;
+  int negative = 0;
+
+  while ( s->pos < s->eol && is_blank(*(s->pos)) )
+    s->pos++;
+
+  p = s->pos;
+  if ( p < s->eol && (*p == '-' || *p == '+') ) {
+    negative = ( *p == '-' );
+    p++;
+  }
+  if ( p == s->eol || *p < '0' || *p > '9' )
+    return 0;
+
+  for ( ; p < s->eol && *p >= '0' && *p <= '9' ; p++ )
+    value = 10 * value + (unsigned long) (*p - '0');
+
+  s->pos = p;
+  *x = negative ? -(int) value : (int) value;
+  return 1;
+}
+
+/* Interface function: reads the next character of the line that is not blank into c.
+   Returns 0 if there is none. */
+int scan_char( scanner *s , char *c )
+{
+  while ( s->pos < s->eol && is_blank(*(s->pos)) )
+    s->pos++;
+  if ( s->pos == s->eol )
+    return 0;
+
+  *c = *(s->pos++);
+  return 1;
+}
+
+/* Private. Reads the stream until there is a whole line after the last one. Returns 0 if
+   the stream ended with no line left. */
+int read_stream( scanner *s )
+{
+  size_t left;
+  ssize_t n;
+
+  while ( memchr( s->next , '\n' , s->end - s->next ) == NULL ) {
+    /* Moves the rest of the buffer to its start, growing it if it is all one line. */
+    left = s->end - s->next;
+    memmove( s->base , s->next , left );
+    if ( left + 1 >= s->max ) {
+      s->max *= 2;
+      s->base = (char*) realloc( s->base , s->max );
+      mem_check(s->base);
+    }
+    s->next = s->pos = s->eol = s->base;
+    s->end = s->base + left;
+
+    n = read( s->fd , s->end , s->max - left - 1 );
+    if ( n > 0 ) {
+      s->end += n;
+    } else if ( n < 0 && errno == EINTR ) {
+      continue;
+    } else if ( left > 0 ) {
+      /* The last line has no newline. */
+      *(s->end++) = '\n';
+    } else if ( n == 0 && s->path != NULL ) {
+      /* The writers of the pipe closed it: waits for the next one. */
+      close( s->fd );
+      if ( (s->fd = open( s->path , O_RDONLY )) < 0 )
+	return 0;
+    } else {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* Private. Reads the whole file, with room for one more byte after it. */
+char* read_whole( int fd , size_t *size )
+{
+  char *data;
+  size_t max = 4096;
+  ssize_t n;
+
+  data = (char*) malloc( max );
+  mem_check(data);
+
+  *size = 0;
+  while ( (n = read( fd , data + *size , max - *size - 1 )) > 0 ) {
+    *size += n;
+    if ( *size + 1 == max ) {
+      max *= 2;
+      data = (char*) realloc( data , max );
+      mem_check(data);
+    }
+  }
+
+  return data;
+}
@@ -0,0 +1,145 @@
+/*
+ *  File name: slab.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: C-Implementation of a slab allocator: objects of a single
+ *      size, taken from large chunks. Has functions to allocate and free an
+ *      object, and to free all of them at once.
+ *
+ *  Implementation details:
+ *    The chunks are a list, each one twice the size of the one before (up to
+ *    a limit), so a slab of few objects takes little memory. The objects of
+ *    a chunk are given in order, and the free objects link to each other by
+ *    their first bytes. Clearing the slab keeps its largest chunk, so a slab
+ *    cleared and used again does not allocate.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "slab.h"
+
+/* Objects in the first chunk, and largest number in a chunk. */
+#define FIRST_CHUNK 64
+#define MAX_CHUNK 65536
+
+/*
+ *  Data Type: chunk (private)
+ *  Description: Structure with:
+ *      1) Previous chunk (smaller), and number of objects.
+ *      2) Objects, after the structure (aligned as a double).
+ */
+typedef struct _chunk {
+  struct _chunk *prev;
+  size_t n;
+  double align;
+} chunk;
+
+#define chunk_data(c) ((char*) &((c)->align))
+
+/*
+ *  Data Type: slab (semi-private)
+ *  Description: Structure with:
+ *      1) Object size (at least a pointer, aligned as a double).
+ *      2) Last chunk, and number of its objects already given.
+ *      3) First free object.
+ */
+struct _slab {
+  size_t size;
+  chunk *last;
+  size_t used;
+  void *free_list;
+};
+
+void new_chunk( slab *s , size_t n );
+
+/* Interface function: Initializes an empty slab, for objects of the size given. */
+slab* new_slab( size_t size )
+{
+  slab *s;
+
+  s = (slab*) malloc( sizeof(slab) );
+  mem_check(s);
+
+  if ( size < sizeof(void*) )
+    size = sizeof(void*);
+  s->size = (size + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+  s->last = NULL;
+  s->used = 0;
+  s->free_list = NULL;
+
+  return s;
+}
+
+/* Interface function: Frees the slab, with all its objects. */
+void destroy_slab( slab *s )
+{
+  chunk *c;
+
+  while ( s->last != NULL ) {
+    c = s->last;
+    s->last = c->prev;
+    free( c );
+  }
+
+  free( s );
+}
+
+/* Interface function: Frees all the objects at once. */
+void clear_slab( slab *s )
+{
+  chunk *c;
+
+  if ( s->last == NULL )
+    return;
+
+  while ( s->last->prev != NULL ) {
+    c = s->last->prev;
+    s->last->prev = c->prev;
+    free( c );
+  }
+
+  s->used = 0;
+  s->free_list = NULL;
+}
+
+/* Interface function: Returns a new object (not initialized). */
+void* alloc_slab( slab *s )
+{
+  void *this;
+
+  if ( s->free_list != NULL ) {
+    this = s->free_list;
+    s->free_list = *((void**) this);
+    return this;
+  }
+
+  if ( s->last == NULL )
+    new_chunk( s , FIRST_CHUNK );
+  else if ( s->used == s->last->n )
+    new_chunk( s , s->last->n < MAX_CHUNK ? 2 * s->last->n : MAX_CHUNK );
+
+  return chunk_data(s->last) + s->size * s->used++;
+}
+
+/* Interface function: Frees an object given by the slab. */
+void free_slab( slab *s , void *this )
+{
+  *((void**) this) = s->free_list;
+  s->free_list = this;
+}
+
+/* Adds a chunk with n objects, that is now the last. */
+void new_chunk( slab *s , size_t n )
+{
+  chunk *c;
+
+  c = (chunk*) malloc( sizeof(chunk) + n * s->size );
+  mem_check(c);
+
+  c->prev = s->last;
+  c->n = n;
+  s->last = c;
+  s->used = 0;
+}
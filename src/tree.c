@@ -0,0 +1,393 @@
+/*
+ *  File name: tree.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Storage of the search trees of the garage: the parent and
+ *               the weight of each cell, in full or packed.
+ *
+ *  Implementation details:
+ *    The 3 bit codes of a packed tree are kept in words, as many codes per
+ *    word as fit (21 in a 64 bit word). Code 0 is a cell with no move to a
+ *    parent: a source (weight 0), a cell not reached, or a blocked cell. The
+ *    last two have special weights, since their weight is -1.
+ *
+ *    The cells kept apart are a list of (cell, parent, weight) triples, in
+ *    increasing order of cell, so a cell is found by binary search. With
+ *    weights below 65533, none is kept apart.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "defs.h"
+#include "tree.h"
+
+/* Codes of the moves to the parent, in a word. */
+#define CODE_BITS 3
+#define CODE_MASK 7UL
+#define CODES_PER_WORD ((int) (8 * sizeof(unsigned long)) / CODE_BITS)
+#define MOVE_NONE 0
+#define NUM_MOVES 6
+
+/* Weights with a special meaning in a packed tree. */
+#define DIST_UNREACHED 0xFFFF
+#define DIST_BLOCKED 0xFFFE
+#define DIST_APART 0xFFFD
+
+/*
+ *  Data Type: tree
+ *  Description: Structure with:
+ *      1) Number of cells, and the parent offset of each move code.
+ *      2) Full trees: spt and wt arrays (NULL for packed trees).
+ *      3) Packed trees: move codes, weights, and the cells kept apart (their
+ *         number and array size).
+ *      4) Whether the arrays belong to a model (not freed with the tree).
+ */
+struct _tree {
+  int V;
+  int moves[NUM_MOVES + 1];
+
+  int *spt, *wt;
+
+  unsigned long *dir;
+  unsigned short *dist;
+  int *apart;
+  int n_apart, max_apart;
+
+  int mapped;
+};
+
+tree* alloc_tree( int N , int M , int P );
+int* find_apart( tree *t , int v );
+void put_apart( tree *t , int v , int spt , int wt );
+void pack_tree( tree *t , int *spt , int *wt );
+void unpack_tree( tree *t , int *spt , int *wt );
+
+/* Allocates a tree for a N x M x P grid, packed or not. Its cells are not reached. */
+tree* new_tree( int N , int M , int P , int packed )
+{
+  tree *t;
+  int i, n_words;
+
+  t = alloc_tree( N , M , P );
+
+  if ( !packed ) {
+    t->spt = (int*) malloc( t->V * sizeof(int) );
+    t->wt = (int*) malloc( t->V * sizeof(int) );
+    mem_check(t->spt);
+    mem_check(t->wt);
+    for ( i = 0 ; i < t->V ; i++ ) {
+      t->spt[i] = t->wt[i] = -1;
+    }
+    return t;
+  }
+
+  n_words = (t->V + CODES_PER_WORD - 1) / CODES_PER_WORD;
+  t->dir = (unsigned long*) calloc( n_words + 1 , sizeof(unsigned long) );
+  t->dist = (unsigned short*) malloc( (t->V + 1) * sizeof(unsigned short) );
+  t->max_apart = 16;
+  t->apart = (int*) malloc( 3 * t->max_apart * sizeof(int) );
+  mem_check(t->dir);
+  mem_check(t->dist);
+  mem_check(t->apart);
+  for ( i = 0 ; i < t->V ; i++ ) {
+    t->dist[i] = DIST_UNREACHED;
+  }
+
+  return t;
+}
+
+/* Private. Allocates the tree structure, with no arrays. */
+tree* alloc_tree( int N , int M , int P )
+{
+  tree *t;
+
+  t = (tree*) malloc( sizeof(tree) );
+  mem_check(t);
+
+  t->V = N * M * P;
+  t->moves[MOVE_NONE] = 0;
+  t->moves[1] = -1;
+  t->moves[2] = 1;
+  t->moves[3] = -N;
+  t->moves[4] = N;
+  t->moves[5] = -N * M;
+  t->moves[6] = N * M;
+
+  t->spt = t->wt = NULL;
+  t->dir = NULL;
+  t->dist = NULL;
+  t->apart = NULL;
+  t->n_apart = t->max_apart = 0;
+  t->mapped = 0;
+
+  return t;
+}
+
+/* Deallocates the tree. The pages of a tree mapped from a model are given back to the
+   system, the model stays mapped. */
+void destroy_tree( tree *t )
+{
+  if ( !t->mapped ) {
+    free( t->spt );
+    free( t->wt );
+    free( t->dir );
+    free( t->dist );
+  } else if ( t->dir == NULL ) {
+    release_model( t->spt , t->V * sizeof(int) );
+    release_model( t->wt , t->V * sizeof(int) );
+  } else {
+    release_model( t->dir , ((t->V + CODES_PER_WORD - 1) / CODES_PER_WORD + 1) * sizeof(unsigned long) );
+    release_model( t->dist , (t->V + 1) * sizeof(unsigned short) );
+  }
+  free( t->apart );
+  free( t );
+}
+
+/* Returns the memory used by a tree for a N x M x P grid (but for the cells kept apart). */
+long bytes_tree( int N , int M , int P , int packed )
+{
+  long V = (long) N * M * P;
+
+  if ( !packed )
+    return 2 * V * (long) sizeof(int);
+
+  return ((V + CODES_PER_WORD - 1) / CODES_PER_WORD + 1) * (long) sizeof(unsigned long) +
+    (V + 1) * (long) sizeof(unsigned short);
+}
+
+/* Checks if the tree is packed. */
+int is_packed_tree( tree *t )
+{
+  return t->dir != NULL;
+}
+
+/* Returns the parent of v in the tree (v for sources, -1 if not reached and -2 if blocked). */
+int parent_tree( tree *t , int v )
+{
+  int code, d;
+
+  if ( t->dir == NULL )
+    return t->spt[v];
+
+  d = t->dist[v];
+  if ( d == DIST_APART )
+    return find_apart( t , v )[1];
+
+  code = (int) ((t->dir[v / CODES_PER_WORD] >> ((v % CODES_PER_WORD) * CODE_BITS)) & CODE_MASK);
+  if ( code != MOVE_NONE )
+    return v + t->moves[code];
+
+  if ( d == DIST_UNREACHED )
+    return -1;
+  if ( d == DIST_BLOCKED )
+    return -2;
+  return v;
+}
+
+/* Returns the weight of v in the tree (-1 if not reached). */
+int weight_tree( tree *t , int v )
+{
+  int d;
+
+  if ( t->dir == NULL )
+    return t->wt[v];
+
+  d = t->dist[v];
+  if ( d == DIST_APART )
+    return find_apart( t , v )[2];
+  if ( d == DIST_UNREACHED || d == DIST_BLOCKED )
+    return -1;
+  return d;
+}
+
+/* Gives the spt and wt arrays of the tree. A packed tree is unpacked in the buffers given
+   (V positions), or only given them if load is 0, when the search makes the tree from nothing. */
+void open_tree( tree *t , int **spt , int **wt , int *buf_spt , int *buf_wt , int load )
+{
+  if ( t->dir == NULL ) {
+    *spt = t->spt;
+    *wt = t->wt;
+    return;
+  }
+
+  *spt = buf_spt;
+  *wt = buf_wt;
+  if ( load )
+    unpack_tree( t , buf_spt , buf_wt );
+}
+
+/* Ends the changes to the arrays given by open_tree, packing them if the tree is packed. */
+void close_tree( tree *t , int *spt , int *wt )
+{
+  if ( t->dir != NULL )
+    pack_tree( t , spt , wt );
+}
+
+/* Private. Packs the arrays in the tree. */
+void pack_tree( tree *t , int *spt , int *wt )
+{
+  unsigned long word = 0;
+  int v, code, d, shift = 0;
+
+  t->n_apart = 0;
+
+  for ( v = 0 ; v < t->V ; v++ ) {
+    d = spt[v] - v;
+    for ( code = 1 ; code <= NUM_MOVES && t->moves[code] != d ; code++ );
+
+    if ( code <= NUM_MOVES && spt[v] >= 0 && wt[v] >= 0 && wt[v] < DIST_APART ) {
+      word |= ((unsigned long) code) << shift;
+      t->dist[v] = (unsigned short) wt[v];
+    } else if ( spt[v] == v && wt[v] == 0 ) {
+      t->dist[v] = 0;
+    } else if ( spt[v] == -1 && wt[v] == -1 ) {
+      t->dist[v] = DIST_UNREACHED;
+    } else if ( spt[v] == -2 && wt[v] == -1 ) {
+      t->dist[v] = DIST_BLOCKED;
+    } else {
+      t->dist[v] = DIST_APART;
+      put_apart( t , v , spt[v] , wt[v] );
+    }
+
+    shift += CODE_BITS;
+    if ( shift == CODES_PER_WORD * CODE_BITS ) {
+      t->dir[v / CODES_PER_WORD] = word;
+      word = 0;
+      shift = 0;
+    }
+  }
+
+  if ( shift != 0 )
+    t->dir[t->V / CODES_PER_WORD] = word;
+}
+
+/* Private. Unpacks the tree to the arrays given. */
+void unpack_tree( tree *t , int *spt , int *wt )
+{
+  unsigned long word = 0;
+  int v, code, d, k = 0;
+
+  for ( v = 0 ; v < t->V ; v++ ) {
+    if ( v % CODES_PER_WORD == 0 )
+      word = t->dir[v / CODES_PER_WORD];
+    code = (int) (word & CODE_MASK);
+    word >>= CODE_BITS;
+
+    d = t->dist[v];
+    if ( code != MOVE_NONE ) {
+      spt[v] = v + t->moves[code];
+      wt[v] = d;
+    } else if ( d == DIST_UNREACHED ) {
+      spt[v] = wt[v] = -1;
+    } else if ( d == DIST_BLOCKED ) {
+      spt[v] = -2;
+      wt[v] = -1;
+    } else if ( d == DIST_APART ) {
+      /* The cells apart are in the same order. */
+      spt[v] = t->apart[3 * k + 1];
+      wt[v] = t->apart[3 * k + 2];
+      k++;
+    } else {
+      spt[v] = v;
+      wt[v] = 0;
+    }
+  }
+}
+
+/* Private. Returns the triple of a cell kept apart. */
+int* find_apart( tree *t , int v )
+{
+  int lo = 0, hi = t->n_apart - 1, mid;
+
+  while ( lo < hi ) {
+    mid = (lo + hi) / 2;
+    if ( t->apart[3 * mid] < v )
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return t->apart + 3 * lo;
+}
+
+/* Private. Keeps a cell apart, after all the others (with lower numbers). */
+void put_apart( tree *t , int v , int spt , int wt )
+{
+  if ( t->n_apart == t->max_apart ) {
+    t->max_apart = 2 * t->max_apart + 1;
+    t->apart = (int*) realloc( t->apart , 3 * t->max_apart * sizeof(int) );
+    mem_check(t->apart);
+  }
+
+  t->apart[3 * t->n_apart] = v;
+  t->apart[3 * t->n_apart + 1] = spt;
+  t->apart[3 * t->n_apart + 2] = wt;
+  t->n_apart++;
+}
+
+/* Writes the tree in a model. */
+void save_tree( tree *t , FILE *fp )
+{
+  int sizes[3];
+
+  sizes[0] = t->V;
+  sizes[1] = ( t->dir != NULL );
+  sizes[2] = t->n_apart;
+  write_model( fp , sizes , sizeof(sizes) );
+
+  if ( t->dir == NULL ) {
+    write_model( fp , t->spt , t->V * sizeof(int) );
+    write_model( fp , t->wt , t->V * sizeof(int) );
+  } else {
+    write_model( fp , t->dir ,
+		 ((t->V + CODES_PER_WORD - 1) / CODES_PER_WORD + 1) * sizeof(unsigned long) );
+    write_model( fp , t->dist , (t->V + 1) * sizeof(unsigned short) );
+    write_model( fp , t->apart , 3 * t->n_apart * sizeof(int) );
+  }
+}
+
+/* Reads a tree written by save_tree, whose arrays stay in the model (but the cells apart,
+   which can grow). Returns NULL if the model does not have a tree of that size. */
+tree* map_tree( model *m , int N , int M , int P )
+{
+  tree *t;
+  int *sizes, *apart, i;
+
+  sizes = (int*) read_model( m , 3 * sizeof(int) );
+  if ( sizes == NULL || sizes[0] != N * M * P )
+    return NULL;
+
+  t = alloc_tree( N , M , P );
+  t->mapped = 1;
+
+  if ( !sizes[1] ) {
+    t->spt = (int*) read_model( m , t->V * sizeof(int) );
+    t->wt = (int*) read_model( m , t->V * sizeof(int) );
+    if ( t->spt == NULL || t->wt == NULL ) {
+      free( t );
+      return NULL;
+    }
+    return t;
+  }
+
+  t->dir = (unsigned long*) read_model( m ,
+	     ((t->V + CODES_PER_WORD - 1) / CODES_PER_WORD + 1) * sizeof(unsigned long) );
+  t->dist = (unsigned short*) read_model( m , (t->V + 1) * sizeof(unsigned short) );
+  apart = (int*) read_model( m , 3 * sizes[2] * sizeof(int) );
+  if ( t->dir == NULL || t->dist == NULL || apart == NULL ) {
+    free( t );
+    return NULL;
+  }
+
+  t->n_apart = sizes[2];
+  t->max_apart = sizes[2] + 16;
+  t->apart = (int*) malloc( 3 * t->max_apart * sizeof(int) );
+  mem_check(t->apart);
+  for ( i = 0 ; i < 3 * t->n_apart ; i++ ) {
+    t->apart[i] = apart[i];
+  }
+
+  return t;
+}
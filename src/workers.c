@@ -0,0 +1,163 @@
+/*
+ *  File name: workers.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Computation of several search trees at the same time, by a
+ *               pool of threads.
+ *
+ *  Implementation details:
+ *    The threads only live while a batch of jobs is run. The batches happen
+ *    when all trees must be made (at the start, and after changes too large
+ *    to repair), so starting the threads costs little next to the searches.
+ *    The caller is one of the workers, with its own workspace, so with a
+ *    single worker (or a single job) no thread is started.
+ *
+ *    Packed trees are searched unpacked, in arrays of the workspace as large
+ *    as the garage. They are made by the caller alone, so those arrays exist
+ *    once and not once per thread, which would undo the packing.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "workers.h"
+
+/* Largest number of threads used, whatever the number of cores. */
+#define MAX_WORKERS 64
+
+/*
+ *  Data Type: batch (private)
+ *  Description: Structure with:
+ *      1) Graph searched and the search arguments shared by all jobs.
+ *      2) The jobs, their number and the next one to take.
+ *      3) Changed vertices, when the trees are repaired (NULL otherwise).
+ *      4) Lock of the next job.
+ */
+typedef struct _batch {
+  graph *g;
+  int *info;
+  int M, N;
+
+  spt_job *jobs;
+  int n_jobs, next;
+
+  int *changed;
+  int n_changed;
+
+  pthread_mutex_t lock;
+} batch;
+
+/* Number of workers, 0 means one per core. */
+static int n_workers = 0;
+
+void* worker( void *arg );
+void take_jobs( batch *b , workspace *w );
+void run_job( batch *b , workspace *w , spt_job *j );
+
+/* Sets the number of workers (0 for one per core). */
+void set_workers( int n )
+{
+  n_workers = n < 0 ? 0 : n;
+}
+
+/* Returns the number of workers a batch may use. */
+int get_workers( void )
+{
+  long n = n_workers;
+
+  if ( n == 0 )
+    n = sysconf( _SC_NPROCESSORS_ONLN );
+  if ( n < 1 )
+    n = 1;
+  if ( n > MAX_WORKERS )
+    n = MAX_WORKERS;
+
+  return (int) n;
+}
+
+/* Makes the trees of all jobs or, when changed is not NULL, repairs them after the flags of
+   the changed vertices were changed, the caller working in w. Returns when all are done. */
+void run_spt_jobs( graph *g , workspace *w , int *info , int M , int N , spt_job *jobs ,
+		   int n_jobs , int *changed , int n_changed )
+{
+  pthread_t threads[MAX_WORKERS];
+  batch b;
+  int i, n;
+
+  if ( n_jobs <= 0 )
+    return;
+
+  b.g = g;
+  b.info = info;
+  b.M = M;
+  b.N = N;
+  b.jobs = jobs;
+  b.n_jobs = n_jobs;
+  b.next = 0;
+  b.changed = changed;
+  b.n_changed = n_changed;
+
+  n = get_workers();
+  if ( n > n_jobs )
+    n = n_jobs;
+  if ( is_packed_tree( jobs[0].t ) )
+    n = 1;
+
+  pthread_mutex_init( &(b.lock) , NULL );
+
+  /* The caller works too, as the last worker. */
+  for ( i = 0 ; i < n - 1 ; i++ ) {
+    if ( pthread_create( &threads[i] , NULL , worker , &b ) != 0 )
+      break;
+  }
+  take_jobs( &b , w );
+
+  n = i;
+  for ( i = 0 ; i < n ; i++ ) {
+    pthread_join( threads[i] , NULL );
+  }
+
+  pthread_mutex_destroy( &(b.lock) );
+}
+
+/* Private. Thread of a worker, with a workspace of its own. */
+void* worker( void *arg )
+{
+  batch *b = (batch*) arg;
+  workspace *w;
+
+  w = new_workspace( b->g );
+  take_jobs( b , w );
+  destroy_workspace( w );
+
+  return NULL;
+}
+
+/* Private. Takes jobs from the batch until there are none left. */
+void take_jobs( batch *b , workspace *w )
+{
+  int i;
+
+  while ( 1 ) {
+    pthread_mutex_lock( &(b->lock) );
+    i = b->next++;
+    pthread_mutex_unlock( &(b->lock) );
+
+    if ( i >= b->n_jobs )
+      break;
+
+    run_job( b , w , &(b->jobs[i]) );
+  }
+}
+
+/* Private. Makes or repairs the tree of one job. */
+void run_job( batch *b , workspace *w , spt_job *j )
+{
+  update_tree( b->g , w , b->info , b->M , b->N , j->t , j->source , b->changed ,
+	       b->n_changed );
+}
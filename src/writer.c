@@ -0,0 +1,364 @@
+/*
+ *  File name: writer.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Writing of the moves of the cars to the output file, through
+ *      a large buffer, with the integers converted by hand.
+ *
+ *  Implementation details:
+ *    The buffer is a set of blocks. A line is always written whole in a
+ *    block (only a tag longer than a block is split), and when the last block
+ *    cannot take it, all the blocks are written at once, by writev. The
+ *    file is only written by the writer, with no stdio buffer in between.
+ *    A stream writer also writes them at the end of each event, so the moves
+ *    of a car are out as soon as it is handled.
+ *
+ *    A write cut by a signal is made again. Any other error is written to the
+ *    standard error once, and the writer fails: what is left is dropped, and
+ *    end_event and close_writer return -1, for the caller to stop.
+ *
+ *    The moves are not checked here: the checks escreve_saida made (and
+ *    more) are in the autopark-verify tool, run on the output file.
+ *
+ *    A binary writer writes the records of binfmt.h instead of the lines,
+ *    with its own copy of the tags (they may not last).
+ *
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "writer.h"
+#include "binfmt.h"
+
+/* Blocks of the buffer, and their size. */
+#define WRITER_BLOCKS 16
+#define BLOCK_SIZE 65536
+
+/* Longest line without the tag: 5 integers, the move and the separators (a record has
+   less: 6 varints). */
+#define MAX_LINE 64
+
+/*
+ *  Data Type: writer (semi-private)
+ *  Description: Structure with:
+ *      1) File descriptor, and its path (for the errors).
+ *      2) Blocks, the one being filled and its size so far (the ones before
+ *         it are full, their sizes are in their iovec).
+ *      3) If it is a stream (written at the end of each event), and if a
+ *         write failed.
+ *      4) For the binary format: the tags so far, the dimensions of the garage
+ *         (for the cells), and the instant of the last move.
+ */
+struct _writer {
+  int fd;
+  char *path;
+  char *blocks;
+  struct iovec iov[WRITER_BLOCKS];
+  int cur;
+  size_t fill;
+  int stream, failed;
+  tag_table *tags;
+  int N, M, t;
+};
+
+writer* new_writer( int fd , char *path , int stream );
+void next_block( writer *w );
+void flush_writer( writer *w );
+void write_record( writer *w , char *vid , int tk , int pX , int pY , int pZ , char tm );
+char* line_start( writer *w );
+void put_text( writer *w , char *text , size_t len );
+char* put_int( char *p , int x );
+
+/* Interface function: creates (or truncates) the file in the path given. Returns NULL if
+   it cannot be opened. */
+writer* open_writer( char *path )
+{
+  int fd;
+
+  fd = open( path , O_WRONLY | O_CREAT | O_TRUNC , 0666 );
+  if ( fd < 0 )
+    return NULL;
+
+  return new_writer( fd , path , 0 );
+}
+
+/* Interface function: creates (or truncates) the file in the path given, in the binary
+   format, for a garage of N by M. Returns NULL if it cannot be opened. */
+writer* binary_writer( char *path , int N , int M )
+{
+  writer *w;
+  char *p;
+
+  if ( (w = open_writer( path )) == NULL )
+    return NULL;
+
+  w->tags = new_tags( 1 );
+  w->N = N;
+  w->M = M;
+
+  p = line_start( w );
+  memcpy( p , RESULTS_MAGIC , MAGIC_SIZE );
+  p = put_varint( p + MAGIC_SIZE , (unsigned long) N );
+  p = put_varint( p , (unsigned long) M );
+  w->fill = p - (char*) w->iov[w->cur].iov_base;
+
+  return w;
+}
+
+/* Interface function: writes to the descriptor given (already open) as a stream. */
+writer* stream_writer( int fd )
+{
+  return new_writer( fd , "(stream)" , 1 );
+}
+
+/* Interface function: marks the end of the moves of an event. A stream writes them now.
+   Returns -1 if a write failed (now or before), 0 otherwise. */
+int end_event( writer *w )
+{
+  if ( w->stream && (w->cur > 0 || w->fill > 0) )
+    flush_writer( w );
+
+  return w->failed ? -1 : 0;
+}
+
+/* Interface function: writes what is left in the buffer and closes the file. Returns -1 if
+   a write failed (or the close did), 0 otherwise. */
+int close_writer( writer *w )
+{
+  int failed;
+
+  flush_writer( w );
+  if ( close( w->fd ) != 0 && !w->failed ) {
+    fprintf(stderr, "Error writing file %s: %s.\n", w->path, strerror(errno));
+    w->failed = 1;
+  }
+  failed = w->failed;
+
+  if ( w->tags != NULL )
+    free_tags( w->tags );
+  free( w->blocks );
+  free( w );
+
+  return failed ? -1 : 0;
+}
+
+/* Private. Makes a writer of the descriptor given. */
+writer* new_writer( int fd , char *path , int stream )
+{
+  writer *w;
+  int i;
+
+  w = (writer*) malloc( sizeof(writer) );
+  mem_check(w);
+
+  w->fd = fd;
+  w->path = path;
+  w->stream = stream;
+  w->failed = 0;
+  w->tags = NULL;
+  w->t = 0;
+
+  w->blocks = (char*) malloc( WRITER_BLOCKS * BLOCK_SIZE );
+  mem_check(w->blocks);
+  for ( i = 0 ; i < WRITER_BLOCKS ; i++ ) {
+    w->iov[i].iov_base = w->blocks + i * BLOCK_SIZE;
+    w->iov[i].iov_len = 0;
+  }
+  w->cur = 0;
+  w->fill = 0;
+
+  return w;
+}
+
+/******************************************************************************
+ * write_move ()
+ *
+ * Arguments: w - writer do ficheiro de saida
+ *            vid - identificador da viatura
+ *            tk - instante de tempo em que ocorre o movimento
+ *            pX, pY, pZ - coordenadas (X,Y,Z) da viatura em movimento
+ *            tm - tipo de movimento
+ * Returns: nada
+ *
+ * Description: escreve no ficheiro de saida um tuplo de valores do tipo
+ *                          Vid T X Y Z M
+ *              sendo Vid o identificador da viatura, T o instante de tempo,
+ *              X, Y e Z  indicam a posicao da viatura no parque de
+ *              estacionamento e M e' o tipo de movimento podendo apenas ter
+ *              os caracteres 'i', 'm', 'e', 'p', 'a', 'x' ou 's'.
+ *
+ *****************************************************************************/
+
+void write_move( writer *w , char *vid , int tk , int pX , int pY , int pZ , char tm )
+{
+  char *p;
+
+  if ( w->tags != NULL ) {
+    write_record( w , vid , tk , pX , pY , pZ , tm );
+    return;
+  }
+
+  put_text( w , vid , strlen( vid ) );
+
+  p = line_start( w );
+  *(p++) = ' ';
+  p = put_int( p , tk );
+  *(p++) = ' ';
+  p = put_int( p , pX );
+  *(p++) = ' ';
+  p = put_int( p , pY );
+  *(p++) = ' ';
+  p = put_int( p , pZ );
+  *(p++) = ' ';
+  *(p++) = tm;
+  *(p++) = '\n';
+
+  w->fill = p - (char*) w->iov[w->cur].iov_base;
+}
+
+/* Private. Writes a move as a record: the tag (whole if it is new), the instant from the last
+   move, and the cell and the code of the move, or for the summary its times and cost. */
+void write_record( writer *w , char *vid , int tk , int pX , int pY , int pZ , char tm )
+{
+  char *p, id[MAX_VARINT];
+  int n;
+
+  if ( (n = find_tag( w->tags , vid )) == -1 ) {
+    n = add_tag( w->tags , vid );
+    put_text( w , id , put_varint( id , (unsigned long) n ) - id );
+    put_text( w , vid , strlen( vid ) + 1 );
+    p = line_start( w );
+  } else {
+    p = line_start( w );
+    p = put_varint( p , (unsigned long) n );
+  }
+
+  p = put_varint( p , zigzag(tk - w->t) );
+  w->t = tk;
+
+  if ( tm == 'x' ) {
+    p = put_varint( p , (unsigned long) move_code( tm ) );
+    p = put_varint( p , zigzag(pX - tk) );
+    p = put_varint( p , zigzag(pY - pX) );
+    p = put_varint( p , zigzag(pZ - (pX - tk) - COST_MULT * (pY - pX)) );
+  } else {
+    p = put_varint( p , (unsigned long) get_index(pX, pY, pZ, w->M, w->N) << MOVE_BITS
+		    | (unsigned long) move_code( tm ) );
+  }
+
+  w->fill = p - (char*) w->iov[w->cur].iov_base;
+}
+
+/* Private. Returns where the rest of a line goes, starting the next block if there is no room
+   for it. */
+char* line_start( writer *w )
+{
+  if ( BLOCK_SIZE - w->fill < MAX_LINE )
+    next_block( w );
+
+  return (char*) w->iov[w->cur].iov_base + w->fill;
+}
+
+/* Private. Closes the block being filled, and starts the next one (writing them all first,
+   if it was the last). */
+void next_block( writer *w )
+{
+  w->iov[w->cur].iov_len = w->fill;
+  w->fill = 0;
+
+  if ( ++(w->cur) == WRITER_BLOCKS )
+    flush_writer( w );
+}
+
+/* Private. Writes all the blocks filled, and starts again from the first. After an error,
+   the blocks are dropped. */
+void flush_writer( writer *w )
+{
+  struct iovec *iov = w->iov;
+  int n;
+  ssize_t done;
+
+  if ( w->cur < WRITER_BLOCKS )
+    w->iov[w->cur].iov_len = w->fill;
+  n = w->cur < WRITER_BLOCKS ? w->cur + 1 : WRITER_BLOCKS;
+
+  /* writev may write only part of them. */
+  while ( n > 0 && !w->failed ) {
+    done = writev( w->fd , iov , n );
+    if ( done < 0 && errno == EINTR )
+      continue;
+    if ( done < 0 ) {
+      fprintf(stderr, "Error writing file %s: %s.\n", w->path, strerror(errno));
+      w->failed = 1;
+      break;
+    }
+
+    for ( ; n > 0 && (size_t) done >= iov->iov_len ; n-- , iov++ )
+      done -= iov->iov_len;
+    if ( n > 0 ) {
+      iov->iov_base = (char*) iov->iov_base + done;
+      iov->iov_len -= done;
+    }
+  }
+
+  for ( n = 0 ; n < WRITER_BLOCKS ; n++ ) {
+    w->iov[n].iov_base = w->blocks + n * BLOCK_SIZE;
+    w->iov[n].iov_len = 0;
+  }
+  w->cur = 0;
+  w->fill = 0;
+}
+
+/* Private. Copies a text of len bytes to the buffer, across blocks if it does not fit in one.
+   The line it starts is kept in one block, if it fits in one. */
+void put_text( writer *w , char *text , size_t len )
+{
+  size_t n;
+
+  if ( len + MAX_LINE <= BLOCK_SIZE && BLOCK_SIZE - w->fill < len + MAX_LINE )
+    next_block( w );
+
+  while ( len > 0 ) {
+    if ( w->fill == BLOCK_SIZE )
+      next_block( w );
+
+    n = BLOCK_SIZE - w->fill < len ? BLOCK_SIZE - w->fill : len;
+    memcpy( (char*) w->iov[w->cur].iov_base + w->fill , text , n );
+    w->fill += n;
+    text += n;
+    len -= n;
+  }
+}
+
+/* Private. Writes x in decimal at p, returning the position after it. */
+char* put_int( char *p , int x )
+{
+  char digits[12];
+  unsigned int u;
+  int n = 0;
+
+  if ( x < 0 ) {
+    *(p++) = '-';
+    u = 0u - (unsigned int) x;
+  } else {
+    u = (unsigned int) x;
+  }
+
+  do {
+    digits[n++] = (char) ('0' + u % 10);
+    u /= 10;
+  } while ( u != 0 );
+
+  while ( n > 0 )
+    *(p++) = digits[--n];
+
+  return p;
+}
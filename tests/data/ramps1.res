@@ -0,0 +1,7 @@
+R 5 0 0 4 0
+R 78 82 1
+R 48 58 1
+R 64 66 3 3 0
+R 109 0 7 5 2
+R 94 123 3 0 2
+R 52 81 6 5 1
@@ -0,0 +1,10 @@
+R 73 80 3 3 0
+R 62 92 3 3 2
+R 64 91 1 4 1
+R 33 49 4 13 0
+R 84 94 5 5 2
+R 98 102 1
+R 85 104 1 5 0
+R 105 108 1
+R 78 96 1
+R 16 0 5 0 0
@@ -0,0 +1,12 @@
+R 89 112 11 5 1
+R 105 0 3 0 1
+R 12 33 0
+R 35 0 1
+R 66 79 5 7 1
+R 63 0 0 5 0
+R 93 96 8 3 1
+R 102 110 1
+R 105 126 6 1 0
+R 96 95 7 2 1
+R 92 115 1
+R 43 59 8 0 1
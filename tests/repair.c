@@ -0,0 +1,238 @@
+/*
+ *  File name: repair.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: Test of repair_spt: a tree repaired after some cells are
+ *      blocked or opened must be the tree a full search gives.
+ *
+ *  Implementation details:
+ *    Random garages, with many ramps, are made as read_map would make them
+ *    (both as CSR and as grid graphs). The tree of an access is then
+ *    repaired after each round of random restrictions, and compared with a
+ *    new search: the same weights, and the same parent for every vertex
+ *    reached.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "graph.h"
+
+#define GARAGES 60
+#define ROUNDS 40
+
+/*
+ *  Data Type: layout
+ *  Description: Structure with:
+ *      1) Dimensions of the garage.
+ *      2) Identification (see defs.h) of each cell.
+ *      3) Accesses (the cells where trees start).
+ */
+typedef struct _layout {
+  int N, M, P;
+  int *info;
+  int *access, n_access;
+} layout;
+
+void random_layout( layout *l );
+graph* make_graph( layout *l , int grid );
+int check_repairs( layout *l , int grid );
+
+int main( int argc , char **argv )
+{
+  layout l;
+  int seed, grid, errors = 0;
+
+  for ( seed = 1 ; seed <= GARAGES ; seed++ ) {
+    for ( grid = 0 ; grid < 2 ; grid++ ) {
+      srand( seed );
+      random_layout( &l );
+      if ( check_repairs( &l , grid ) != 0 ) {
+	fprintf(stderr, "repair: garage %d (%s graph) differs from a full search.\n",
+		seed, grid ? "grid" : "csr");
+	errors++;
+      }
+      free( l.info );
+      free( l.access );
+    }
+  }
+
+  printf("repair: %d trees compared, %d errors.\n", 2 * GARAGES, errors);
+  return errors == 0 ? 0 : 1;
+}
+
+/* Makes a random garage: free cells, walls, parks and ramps inside, and accesses on the
+   borders of each floor. */
+void random_layout( layout *l )
+{
+  int x, y, z, v, k, r, NM;
+
+  l->N = 6 + rand() % 10;
+  l->M = 5 + rand() % 8;
+  l->P = 1 + rand() % 3;
+  NM = l->N * l->M;
+
+  l->info = (int*) malloc( NM * l->P * sizeof(int) );
+  l->access = (int*) malloc( NM * l->P * sizeof(int) );
+  mem_check(l->info);
+  mem_check(l->access);
+  l->n_access = 0;
+
+  for ( v = 0 ; v < NM * l->P ; v++ ) {
+    x = get_x(v, l->N);
+    y = get_y(v, l->M, l->N);
+
+    if ( x == 0 || y == 0 || x == l->N - 1 || y == l->M - 1 ) {
+      l->info[v] = new_id(INVALID, CELL_WALL);
+    } else {
+      r = rand() % 100;
+      if ( r < 55 )
+	l->info[v] = new_id(EMPTY, CELL_FREE);
+      else if ( r < 80 )
+	l->info[v] = new_id(PARK_PLACE_E, CELL_STOP);
+      else if ( r < 85 )
+	l->info[v] = new_id(PARK_PLACE_O, CELL_STOP);
+      else
+	l->info[v] = new_id(INVALID, CELL_WALL);
+    }
+  }
+
+  /* Ramps: an up on a floor, and a down above it. */
+  for ( z = 0 ; z + 1 < l->P ; z++ ) {
+    for ( k = 1 + rand() % 4 ; k > 0 ; k-- ) {
+      v = get_index(1 + rand() % (l->N - 2), 1 + rand() % (l->M - 2), z, l->M, l->N);
+      l->info[v] = new_id(UP, CELL_RAMP);
+      l->info[v + NM] = new_id(DOWN, CELL_FREE);
+    }
+  }
+
+  /* Accesses, on the sides of each floor. */
+  for ( z = 0 ; z < l->P ; z++ ) {
+    for ( k = 1 + rand() % 3 ; k > 0 ; k-- ) {
+      if ( rand() % 2 )
+	v = get_index(rand() % 2 ? 0 : l->N - 1, 1 + rand() % (l->M - 2), z, l->M, l->N);
+      else
+	v = get_index(1 + rand() % (l->N - 2), rand() % 2 ? 0 : l->M - 1, z, l->M, l->N);
+      if ( get_kind(l->info[v]) == CELL_WALL ) {
+	l->info[v] = new_id(INVALID, CELL_STOP);
+	l->access[l->n_access++] = v;
+      }
+    }
+  }
+}
+
+/* Makes the graph of a garage, linking the cells as read_map does (or a grid graph). */
+graph* make_graph( layout *l , int grid )
+{
+  graph *g;
+  int x, y, z, v, kind;
+
+  if ( grid )
+    return new_grid_graph( l->N , l->M , l->P , l->info );
+
+  g = new_graph( l->N * l->M * l->P );
+  for ( z = 0 ; z < l->P ; z++ ) {
+    for ( y = l->M - 1 ; y >= 0 ; y-- ) {
+      for ( x = 0 ; x < l->N ; x++ ) {
+	v = get_index(x, y, z, l->M, l->N);
+	kind = get_kind(l->info[v]);
+	if ( kind == CELL_WALL )
+	  continue;
+
+	if ( y != l->M - 1 && linked_kinds(kind, get_kind(l->info[v + l->N])) )
+	  insertE_graph( g , v , v + l->N , 1 );
+	if ( x != 0 && linked_kinds(kind, get_kind(l->info[v - 1])) )
+	  insertE_graph( g , v , v - 1 , 1 );
+	if ( kind == CELL_RAMP && z + 1 < l->P )
+	  insertE_graph( g , v , v + l->N * l->M , 2 );
+      }
+    }
+  }
+  finalize_graph( g );
+
+  return g;
+}
+
+/* Repairs the tree of each access after rounds of random restrictions, comparing it with a
+   full search each time. Returns the number of trees that differ. */
+int check_repairs( layout *l , int grid )
+{
+  graph *g;
+  workspace *w;
+  int V = l->N * l->M * l->P;
+  int *spt, *wt, *fresh_spt, *fresh_wt, *changed, *blocked;
+  int a, r, i, k, v, n, errors = 0;
+
+  g = make_graph( l , grid );
+  w = new_workspace( g );
+  spt = (int*) malloc( V * sizeof(int) );
+  wt = (int*) malloc( V * sizeof(int) );
+  fresh_spt = (int*) malloc( V * sizeof(int) );
+  fresh_wt = (int*) malloc( V * sizeof(int) );
+  changed = (int*) malloc( V * sizeof(int) );
+  blocked = (int*) calloc( V , sizeof(int) );
+  mem_check(spt);
+  mem_check(wt);
+  mem_check(fresh_spt);
+  mem_check(fresh_wt);
+  mem_check(changed);
+  mem_check(blocked);
+
+  for ( a = 0 ; a < l->n_access ; a++ ) {
+    generate_spt( g , w , l->info , l->M , l->N , spt , wt , l->access[a] );
+
+    for ( r = 0 ; r < ROUNDS ; r++ ) {
+      /* Blocks or opens a few cells, near the access more often than not. */
+      for ( k = 1 + rand() % 4 ; k > 0 ; k-- ) {
+	v = rand() % 2 ? rand() % V : l->access[a] + (rand() % 5 - 2) + (rand() % 3 - 1) * l->N;
+	if ( v < 0 || v >= V || get_kind(l->info[v]) == CELL_WALL || blocked[v] == 1 )
+	  continue;
+	blocked[v] = 1;
+	if ( get_flag(l->info[v]) )
+	  reset_flag(l->info[v]);
+	else
+	  set_flag(l->info[v]);
+      }
+
+      /* The changes are given in order, as the garage gives them. */
+      n = 0;
+      for ( i = 0 ; i < V ; i++ ) {
+	if ( blocked[i] == 1 ) {
+	  changed[n++] = i;
+	  blocked[i] = 0;
+	}
+      }
+
+      repair_spt( g , w , l->info , l->M , l->N , spt , wt , l->access[a] , changed , n );
+      generate_spt( g , w , l->info , l->M , l->N , fresh_spt , fresh_wt , l->access[a] );
+
+      for ( i = 0 ; i < V ; i++ ) {
+	if ( wt[i] != fresh_wt[i] || (fresh_spt[i] >= 0) != (spt[i] >= 0) ||
+	     (fresh_spt[i] >= 0 && spt[i] != fresh_spt[i]) )
+	  break;
+      }
+      if ( i < V ) {
+	errors++;
+	break;
+      }
+    }
+
+    /* The next access starts with no restrictions. */
+    for ( i = 0 ; i < V ; i++ ) {
+      reset_flag(l->info[i]);
+    }
+  }
+
+  destroy_workspace( w );
+  destroy_graph( g );
+  free( spt );
+  free( wt );
+  free( fresh_spt );
+  free( fresh_wt );
+  free( changed );
+  free( blocked );
+
+  return errors;
+}
@@ -0,0 +1,111 @@
+/*
+ *  File name: bin2pts.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: autopark-bin2pts, converts a binary output file (.ptb) of
+ *      autopark to the text one (.pts) it would have written for the text
+ *      cars file.
+ *
+ *  Implementation details:
+ *    The records (see binfmt.h) are read from the file mapped, and the moves
+ *    are written by the writer of autopark, so the text is the same, byte
+ *    for byte.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "binfmt.h"
+#include "scanner.h"
+#include "writer.h"
+
+#define USAGE "Use: ./autopark-bin2pts file.ptb file.pts \n"
+
+int read_move( tag_table *tags , char **p , char *end , int *t , int N , int M , writer *out );
+
+int main( int argc , char **argv )
+{
+  scanner *in;
+  writer *out;
+  tag_table *tags;
+  char *data, *p, *end;
+  size_t size;
+  unsigned long N = 0, M = 0;
+  int t = 0, valid = 1;
+  long count = 0;
+
+  if ( argc < 3 ) {
+    fprintf(stderr, "Too few arguments. " USAGE);
+    exit(0);
+  }
+
+  in = open_scanner( argv[1] );
+  file_check(in, argv[1]);
+  data = data_scanner( in , &size );
+  p = data + MAGIC_SIZE;
+  end = data + size;
+
+  if ( size < MAGIC_SIZE || memcmp( data , RESULTS_MAGIC , MAGIC_SIZE ) != 0
+       || !get_varint( &p , end , &N ) || !get_varint( &p , end , &M ) || N == 0 || M == 0 ) {
+    fprintf(stderr, "File %s is not a binary output file.\n", argv[1]);
+    exit(1);
+  }
+
+  out = open_writer( argv[2] );
+  file_check(out, argv[2]);
+
+  /* The tags are read where they are in the mapping. */
+  tags = new_tags( 0 );
+
+  while ( p < end && (valid = read_move( tags , &p , end , &t , (int) N , (int) M , out )) )
+    count++;
+
+  if ( !valid )
+    fprintf(stderr, "Invalid record in file %s.\n", argv[1]);
+  printf("%s: %ld moves.\n", argv[2], count);
+
+  if ( close_writer( out ) != 0 )
+    valid = 0;
+  free_tags( tags );
+  close_scanner( in );
+
+  exit( valid ? 0 : 1 );
+}
+
+/* Reads the record at *p (before end) and writes its move. t is the instant of the last move.
+   Returns 0 if the record is not valid. */
+int read_move( tag_table *tags , char **p , char *end , int *t , int N , int M , writer *out )
+{
+  char *tag;
+  unsigned long u, v[3];
+  int code, cell, t_p, t_a, i;
+
+  if ( (tag = get_tag( tags , p , end )) == NULL || !get_varint( p , end , &u ) )
+    return 0;
+  *t += (int) unzigzag(u);
+
+  if ( !get_varint( p , end , &u ) )
+    return 0;
+  code = (int) (u & ((1 << MOVE_BITS) - 1));
+  cell = (int) (u >> MOVE_BITS);
+  if ( code >= (int) strlen( MOVE_CODES ) )
+    return 0;
+
+  if ( MOVE_CODES[code] != 'x' ) {
+    write_move( out , tag , *t , get_x(cell, N) , get_y(cell, M, N) , get_z(cell, N, M) , MOVE_CODES[code] );
+    return 1;
+  }
+
+  /* The summary: the times to the park and to the arrival, and the cost less the one they make. */
+  for ( i = 0 ; i < 3 ; i++ )
+    if ( !get_varint( p , end , &v[i] ) )
+      return 0;
+
+  t_p = *t + (int) unzigzag(v[0]);
+  t_a = t_p + (int) unzigzag(v[1]);
+  write_move( out , tag , *t , t_p , t_a , (int) unzigzag(v[2]) + (t_p - *t) + COST_MULT * (t_a - t_p) , 'x' );
+
+  return 1;
+}
@@ -0,0 +1,95 @@
+/*
+ *  File name: inp2bin.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: autopark-inp2bin, converts a cars file (.inp) from text to
+ *      the binary format of binfmt.h, that autopark reads as it reads the text.
+ *
+ *  Implementation details:
+ *    The events are read as autopark reads them (see events.h), so the lines
+ *    it skips are left out, and the fields that are not in a line are not
+ *    in its record either. The records are written through stdio.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "events.h"
+#include "binfmt.h"
+
+#define USAGE "Use: ./autopark-inp2bin file.inp file.bin \n"
+
+/* Longest record without a new tag: the varints and the type. */
+#define MAX_RECORD (6 * MAX_VARINT + 2)
+
+int main( int argc , char **argv )
+{
+  events *in;
+  FILE *out;
+  tag_table *tags;
+  car_event e;
+  char record[MAX_RECORD], *p;
+  int id, i, n, t = 0;
+  long count = 0;
+
+  if ( argc < 3 ) {
+    fprintf(stderr, "Too few arguments. " USAGE);
+    exit(0);
+  }
+
+  in = open_events( argv[1] );
+  file_check(in, argv[1]);
+  if ( binary_events( in ) ) {
+    fprintf(stderr, "File %s is already binary.\n", argv[1]);
+    exit(1);
+  }
+
+  out = fopen( argv[2] , "wb" );
+  file_check(out, argv[2]);
+  fwrite( EVENTS_MAGIC , 1 , MAGIC_SIZE , out );
+
+  /* The tags last as long as the cars file, so the table points to them. */
+  tags = new_tags( 0 );
+
+  while ( next_event( in , &e ) ) {
+    p = record;
+    if ( (id = find_tag( tags , e.tag )) == -1 ) {
+      id = add_tag( tags , e.tag );
+      fwrite( record , 1 , put_varint( record , (unsigned long) id ) - record , out );
+      fwrite( e.tag , 1 , strlen( e.tag ) + 1 , out );
+    } else {
+      p = put_varint( p , (unsigned long) id );
+    }
+
+    p = put_varint( p , zigzag(e.t - t) );
+    t = e.t;
+
+    n = e.fields - 2;
+    if ( n < 0 ) {
+      *(p++) = '\0';
+      *(p++) = 0;
+    } else {
+      *(p++) = e.type;
+      *(p++) = (char) n;
+      for ( i = 0 ; i < n ; i++ )
+	p = put_varint( p , zigzag(e.pos[i]) );
+    }
+
+    fwrite( record , 1 , p - record , out );
+    count++;
+  }
+
+  if ( fclose( out ) != 0 ) {
+    fprintf(stderr, "Error writing file %s.\n", argv[2]);
+    exit(1);
+  }
+
+  printf("%s: %ld events.\n", argv[2], count);
+
+  free_tags( tags );
+  close_events( in );
+
+  exit(0);
+}
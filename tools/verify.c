@@ -0,0 +1,366 @@
+/*
+ *  File name: verify.c
+ *
+ *  Authors: Miguel Malaca & Miguel Pinho
+ *
+ *  Description: autopark-verify, checks an output file (.pts) of autopark
+ *      against the configuration (.cfg) of its garage.
+ *
+ *  Implementation details:
+ *    The output file is read a line at a time, keeping the route of each car
+ *    (by tag) so far: its phase (waiting, driving, walking, arrived, done),
+ *    and its last position and instant. Each move of a route is a straight
+ *    line from the last one, and every step of it is checked as the search
+ *    would take it: the cells must be linked (see defs.h), the cells in
+ *    between must be passable (free or ramps), a ramp entered from its floor
+ *    must be left to the other floor, and the instants must add 1 per step
+ *    on a floor and 2 per floor changed. The walk to the exit follows the
+ *    tree searched from the exits, so there the ramp rule is seen backwards:
+ *    a ramp left to its floor must have been entered from the other floor. This covers the checks escreve_saida
+ *    made (later instant, no diagonal moves, no lateral move while changing
+ *    floor). The first move after the entry may come later, if the car had
+ *    to wait.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "garage.h"
+#include "scanner.h"
+#include "containers.h"
+
+#define USAGE "Use: ./autopark-verify file.cfg file.pts \n"
+
+/* Phases of a route. */
+#define WAITING 0
+#define DRIVING 1
+#define WALKING 2
+#define ARRIVED 3
+#define DONE 4
+
+/*
+ *  Data Type: route
+ *  Description: Structure with:
+ *      1) Phase, last position and instant.
+ *      2) Instants of the entry, park and arrival (for the summary line).
+ *      3) Cell before the last position (-1 if none).
+ */
+typedef struct _route {
+  int phase, pos, t;
+  int t_e, t_p, t_a;
+  int prev;
+} route;
+
+#define tag_equal(a, b) (strcmp((a), (b)) == 0)
+
+DEFINE_HASHMAP(route_map, char*, route, car_function, tag_equal)
+
+/*
+ *  Data Type: layout
+ *  Description: Structure with:
+ *      1) Dimensions of the garage.
+ *      2) Symbol and identification (see defs.h) of each cell.
+ */
+typedef struct _layout {
+  int N, M, P;
+  char *symbol;
+  int *info;
+} layout;
+
+static char *pts_path;
+static long line, errors;
+
+void read_layout( scanner *in , layout *l );
+void check_line( layout *l , route_map *routes , char *tag , int t , int x , int y , int z , char m );
+int check_move( layout *l , route *r , int to , int walking , const char **msg );
+int same_floor( layout *l , int u , int v );
+int is_park( layout *l , int v );
+int is_passable( layout *l , int v );
+void report( char *tag , const char *msg );
+
+int main( int argc , char **argv )
+{
+  scanner *cfg_in, *pts_in;
+  layout l;
+  route_map routes;
+  char *tag, m;
+  int v[4], i;
+
+  if ( argc < 3 ) {
+    fprintf(stderr, "Too few arguments. " USAGE);
+    exit(0);
+  }
+
+  cfg_in = open_scanner( argv[1] );
+  file_check(cfg_in, argv[1]);
+  read_layout( cfg_in , &l );
+  close_scanner( cfg_in );
+
+  pts_in = open_scanner( argv[2] );
+  file_check(pts_in, argv[2]);
+  pts_path = argv[2];
+
+  route_map_init( &routes , H_TABLE_SIZE );
+
+  for ( line = 1 ; next_line( pts_in ) ; line++ ) {
+    /* Each line is "tag t x y z m" (or "tag t_e t_p t_a cost x"). */
+    tag = scan_token( pts_in );
+    for ( i = 0 ; i < 4 && scan_int( pts_in , &v[i] ) ; i++ );
+    if ( tag == NULL || i < 4 || !scan_char( pts_in , &m ) ) {
+      report( tag == NULL ? "" : tag , "malformed line" );
+      continue;
+    }
+
+    check_line( &l , &routes , tag , v[0] , v[1] , v[2] , v[3] , m );
+  }
+
+  /* The cars that entered are either still waiting, or made all their route. */
+  line = 0;
+  for ( i = 0 ; i < routes.size ; i++ ) {
+    if ( routes.slots[i].dist != -1 && routes.slots[i].value.phase != WAITING &&
+	 routes.slots[i].value.phase != DONE )
+      report( routes.slots[i].key , "route not finished" );
+  }
+
+  printf("%s: %ld errors.\n", argv[2], errors);
+
+  route_map_free( &routes );
+  close_scanner( pts_in );
+  free( l.symbol );
+  free( l.info );
+
+  exit( errors == 0 ? 0 : 1 );
+}
+
+/* Reads the cells of the garage from its configuration: the dimensions, and then for each
+   floor its rows (from the last) and accesses (until a '+'). */
+void read_layout( scanner *in , layout *l )
+{
+  char *row, *tag;
+  int i, j, z, len, index, E, A;
+
+  if ( !next_line( in ) || !scan_int( in , &l->N ) || !scan_int( in , &l->M ) ||
+       !scan_int( in , &l->P ) || !scan_int( in , &E ) || !scan_int( in , &A ) ) {
+    fprintf(stderr, "Error reading *.cfg file. \n");
+    exit(0);
+  }
+
+  l->symbol = (char*) malloc( l->N * l->M * l->P * sizeof(char) );
+  l->info = (int*) malloc( l->N * l->M * l->P * sizeof(int) );
+  mem_check(l->symbol);
+  mem_check(l->info);
+
+  for ( z = 0 ; z < l->P ; z++ ) {
+    for ( i = l->M - 1 ; i >= 0 ; i-- ) {
+      if ( !next_line( in ) ) {
+	fprintf(stderr, "Error reading *.cfg file. \n");
+	exit(0);
+      }
+      row = scan_line( in , &len );
+
+      for ( j = 0 ; j < l->N ; j++ ) {
+	index = get_index(j, i, z, l->M, l->N);
+	l->symbol[index] = j < len ? row[j] : '\0';
+	l->info[index] = get_identifier( l->symbol[index] );
+      }
+    }
+
+    while ( next_line( in ) && (tag = scan_token( in )) != NULL && tag[0] != '+' );
+  }
+}
+
+/* Checks a line of the output, of the car with the tag given, against its route so far. */
+void check_line( layout *l , route_map *routes , char *tag , int t , int x , int y , int z , char m )
+{
+  route *r, new;
+  const char *msg;
+  int v, cost;
+
+  if ( m == 'x' ) {
+    /* Summary: instants of entry, park and arrival, and the cost. */
+    r = route_map_get( routes , tag );
+    if ( r == NULL || r->phase != ARRIVED )
+      report( tag , "summary of a route not finished" );
+    else if ( t != r->t_e || x != r->t_p || y != r->t_a )
+      report( tag , "summary instants differ from the route" );
+    else if ( z != (x - t) + COST_MULT * (y - x) )
+      report( tag , "wrong cost" );
+    else
+      r->phase = DONE;
+    return;
+  }
+
+  if ( t < 0 || x < 0 || y < 0 || z < 0 || x >= l->N || y >= l->M || z >= l->P ) {
+    report( tag , "position or instant out of range" );
+    return;
+  }
+  v = get_index(x, y, z, l->M, l->N);
+
+  if ( m == 's' ) {
+    /* A car left its park, if it was parked (and not waiting). */
+    if ( !is_park( l , v ) )
+      report( tag , "exit from a cell that is not a park" );
+    return;
+  }
+
+  if ( m == 'i' ) {
+    if ( l->symbol[v] != 'e' )
+      report( tag , "entry in a cell that is not an entry" );
+
+    new.phase = WAITING;
+    new.pos = v;
+    new.t = new.t_e = t;
+    new.t_p = new.t_a = -1;
+    new.prev = -1;
+
+    /* A tag can enter again, after its route (or after leaving while waiting). */
+    if ( (r = route_map_get( routes , tag )) == NULL ) {
+      route_map_put( routes , tag , new );
+    } else {
+      if ( r->phase != WAITING && r->phase != DONE )
+	report( tag , "car entered during its route" );
+      *r = new;
+    }
+    return;
+  }
+
+  r = route_map_get( routes , tag );
+  if ( r == NULL ) {
+    report( tag , "move of a car that did not enter" );
+    return;
+  }
+
+  /* The type of move must fit the phase of the route. */
+  if ( (m == 'm' || m == 'e') && r->phase != WAITING && r->phase != DRIVING ) {
+    report( tag , "driving after parking" );
+    return;
+  } else if ( (m == 'p' || m == 'a') && r->phase != WALKING ) {
+    report( tag , "walking before parking" );
+    return;
+  } else if ( m != 'm' && m != 'e' && m != 'p' && m != 'a' ) {
+    report( tag , "unknown type of move" );
+    return;
+  }
+
+  /* The car may have waited before its first move. */
+  cost = check_move( l , r , v , m == 'p' || m == 'a' , &msg );
+  if ( cost < 0 )
+    report( tag , msg );
+  else if ( r->phase == WAITING ? t < r->t + cost : t != r->t + cost )
+    report( tag , "instant does not match the length of the move" );
+
+  /* The end of the move must be where the move type says. */
+  if ( m == 'e' && !is_park( l , v ) )
+    report( tag , "parked in a cell that is not a park" );
+  else if ( m == 'a' && l->symbol[v] != 'a' )
+    report( tag , "arrived at a cell that is not an exit" );
+  else if ( (m == 'm' || m == 'p') && !is_passable( l , v ) )
+    report( tag , "turn in a cell that is not free" );
+
+  r->pos = v;
+  r->t = t;
+  if ( m == 'm' ) {
+    r->phase = DRIVING;
+  } else if ( m == 'e' ) {
+    r->phase = WALKING;
+    r->t_p = t;
+  } else if ( m == 'a' ) {
+    r->phase = ARRIVED;
+    r->t_a = t;
+  }
+}
+
+/* Checks the straight move of a route (driving or walking) from its last position to the
+   cell given, step by step. Returns its length in instants, or -1 with the reason in msg
+   (the route is only changed if the move is valid). */
+int check_move( layout *l , route *r , int to , int walking , const char **msg )
+{
+  int from = r->pos, dx, dy, dz, step, w = r->prev, u, v, cost = 0, id, other;
+
+  dx = get_x(to, l->N) - get_x(from, l->N);
+  dy = get_y(to, l->M, l->N) - get_y(from, l->M, l->N);
+  dz = get_z(to, l->N, l->M) - get_z(from, l->N, l->M);
+
+  if ( dx == 0 && dy == 0 && dz == 0 ) {
+    *msg = "car did not move";
+    return -1;
+  } else if ( dz != 0 && (dx != 0 || dy != 0) ) {
+    *msg = "lateral move while changing floor";
+    return -1;
+  } else if ( dx != 0 && dy != 0 ) {
+    *msg = "diagonal move";
+    return -1;
+  }
+
+  if ( dx != 0 )
+    step = dx > 0 ? 1 : -1;
+  else if ( dy != 0 )
+    step = dy > 0 ? l->N : -l->N;
+  else
+    step = dz > 0 ? l->N * l->M : -l->N * l->M;
+
+  for ( u = from ; u != to ; w = u , u = v ) {
+    v = u + step;
+
+    /* A ramp entered from its floor must be left to the other ramp (backwards, walking). */
+    id = get_id(l->info[u]);
+    if ( w != -1 && (id == UP || id == DOWN) ) {
+      other = walking ? get_id(l->info[w]) : get_id(l->info[v]);
+      if ( same_floor( l , walking ? u : w , walking ? v : u ) && other != (id == UP ? DOWN : UP) ) {
+	*msg = "ramp crossed without changing floor";
+	return -1;
+      }
+    }
+
+    if ( dz == 0 ) {
+      if ( !linked_kinds(get_kind(l->info[u]), get_kind(l->info[v])) ) {
+	*msg = "move between cells that are not linked";
+	return -1;
+      }
+      cost += 1;
+    } else {
+      if ( get_kind(l->info[dz > 0 ? u : v]) != CELL_RAMP ) {
+	*msg = "floor changed without a ramp";
+	return -1;
+      }
+      cost += 2;
+    }
+
+    if ( v != to && !is_passable( l , v ) ) {
+      *msg = "move through a cell that is not free";
+      return -1;
+    }
+  }
+
+  r->prev = w;
+  return cost;
+}
+
+/* Returns 1 if the cells are on the same floor. */
+int same_floor( layout *l , int u , int v )
+{
+  return get_z(u, l->N, l->M) == get_z(v, l->N, l->M);
+}
+
+/* Returns 1 if the cell is a park (free or taken at the start). */
+int is_park( layout *l , int v )
+{
+  return get_id(l->info[v]) == PARK_PLACE_E || get_id(l->info[v]) == PARK_PLACE_O;
+}
+
+/* Returns 1 if a route can go through the cell (a free cell or a ramp). */
+int is_passable( layout *l , int v )
+{
+  return get_id(l->info[v]) == EMPTY || get_id(l->info[v]) == UP || get_id(l->info[v]) == DOWN;
+}
+
+/* Reports an error of the line being checked (or of the whole file, at line 0). */
+void report( char *tag , const char *msg )
+{
+  if ( line > 0 )
+    fprintf(stderr, "%s:%ld: %s (%s).\n", pts_path, line, msg, tag);
+  else
+    fprintf(stderr, "%s: %s (%s).\n", pts_path, msg, tag);
+  errors++;
+}